@@ -0,0 +1,43 @@
+# Copyright (c) 2022 Leandro José Britto de Oliveira
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+CPP_PROJECT_BUILDER ?= make
+
+O ?= output/bench
+
+PROJ_NAME := comm-bench
+PROJ_TYPE := app
+
+SRC_DIRS += bench
+
+CFLAGS  += -O2 -pthread
+LDFLAGS += -pthread
+
+# LTO=1 enables link-time optimization (lets stream dispatch inline across translation units)
+ifeq ($(LTO), 1)
+    CFLAGS  += -flto
+    LDFLAGS += -flto
+endif
+
+.PHONY: run
+run: all
+	@$(O_DIST_DIR)/bin/comm-bench0
+
+include $(CPP_PROJECT_BUILDER)/builder.mk
@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "buffer.h"
+#include "../bench.h"
+
+#include <comm.h>
+#include <string.h>
+
+#define __CAPACITY   (128 * 1024)
+#define __TOTAL_SIZE (64 * 1024 * 1024)
+
+typedef struct __legacy_buffer __legacy_buffer_t;
+
+// Byte-per-iteration ring buffer (reference implementation used before bulk copies)
+struct __legacy_buffer {
+	uint8_t storage[__CAPACITY];
+	size_t  readCursor;
+	size_t  writeCursor;
+};
+
+static uint32_t __legacy_write(__legacy_buffer_t* buffer, const uint8_t* in, uint32_t len) {
+	for (uint32_t i = 0; i < len; ++i) {
+		buffer->storage[buffer->writeCursor] = in[i];
+		buffer->writeCursor++;
+
+		if (buffer->writeCursor == __CAPACITY)
+			buffer->writeCursor = 0;
+	}
+
+	return len;
+}
+
+static uint32_t __legacy_read(__legacy_buffer_t* buffer, uint8_t* out, uint32_t len) {
+	for (uint32_t i = 0; i < len; ++i) {
+		if (out != NULL)
+			out[i] = buffer->storage[buffer->readCursor];
+
+		buffer->readCursor++;
+
+		if (buffer->readCursor == __CAPACITY)
+			buffer->readCursor = 0;
+	}
+
+	return len;
+}
+
+static void __bench_chunk(uint32_t chunkSize) {
+	static uint8_t in[64 * 1024];
+	static uint8_t out[64 * 1024];
+	static __legacy_buffer_t legacy;
+
+	uint64_t iterations = __TOTAL_SIZE / chunkSize;
+	uint64_t start;
+	uint64_t legacyNs;
+	uint64_t bulkNs;
+	uint64_t mirroredNs;
+
+	memset(in, 0x5a, chunkSize);
+
+	legacy.readCursor = 0;
+	legacy.writeCursor = 0;
+	start = bench_now_ns();
+	for (uint64_t i = 0; i < iterations; i++) {
+		__legacy_write(&legacy, in, chunkSize);
+		__legacy_read(&legacy, out, chunkSize);
+	}
+	legacyNs = bench_now_ns() - start;
+
+	comm_buffer_t* buffer = comm_buffer_new(__CAPACITY - 1, NULL, NULL); // Odd capacity forces wrap-around
+	start = bench_now_ns();
+	for (uint64_t i = 0; i < iterations; i++) {
+		comm_stream_write(buffer, in, chunkSize);
+		comm_stream_read(buffer, out, chunkSize);
+	}
+	bulkNs = bench_now_ns() - start;
+	comm_obj_del(buffer);
+
+	buffer = comm_buffer_new_mirrored(__CAPACITY, NULL, NULL); // Page-aligned capacity (mirrored storage where supported)
+	start = bench_now_ns();
+	for (uint64_t i = 0; i < iterations; i++) {
+		comm_stream_write(buffer, in, chunkSize);
+		comm_stream_read(buffer, out, chunkSize);
+	}
+	mirroredNs = bench_now_ns() - start;
+	comm_obj_del(buffer);
+
+	BENCH_LOG(
+		"  %6u B: legacy %9.1f MB/s | bulk %9.1f MB/s | mirrored %9.1f MB/s",
+		chunkSize,
+		bench_mb_per_s(iterations * chunkSize, legacyNs),
+		bench_mb_per_s(iterations * chunkSize, bulkNs),
+		bench_mb_per_s(iterations * chunkSize, mirroredNs)
+	);
+}
+
+static void __bench_throughput() {
+	BENCH_LOG("buffer: write+read throughput");
+
+	for (uint32_t chunkSize = 1; chunkSize <= 64 * 1024; chunkSize *= 4)
+		__bench_chunk(chunkSize);
+}
+
+static double __bench_calls(size_t capacity) {
+	comm_buffer_t* buffer = comm_buffer_new(capacity, NULL, NULL);
+	uint32_t iterations = 10000000;
+	uint32_t available = 0;
+	uint8_t b = 0;
+
+	uint64_t start = bench_now_ns();
+	for (uint32_t i = 0; i < iterations; i++) {
+		available += comm_stream_available_write(buffer);
+		comm_stream_write(buffer, &b, 1);
+		available += comm_stream_available_read(buffer);
+		comm_stream_read(buffer, &b, 1);
+	}
+	uint64_t elapsed = bench_now_ns() - start;
+
+	comm_obj_del(buffer);
+
+	if (available == 0)
+		BENCH_LOG("unexpected availability");
+
+	return (double)elapsed / iterations / 4;
+}
+
+static void __bench_per_call() {
+	BENCH_LOG("buffer: cost per call (available_write/write/available_read/read, 1 B)");
+	BENCH_LOG("  capacity 2047 (wrapping cursors): %.2f ns", __bench_calls(2047));
+	BENCH_LOG("  capacity 2048 (power of two):     %.2f ns", __bench_calls(2048));
+}
+
+void bench_buffer() {
+	__bench_throughput();
+	__bench_per_call();
+}
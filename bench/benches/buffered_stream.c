@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "buffered_stream.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+
+#define __LINES_PER_ROUND 64
+#define __ROUNDS          500
+#define __BLOCK_SIZE      4096
+
+static const char __line[] = "0123456789012345678901234567890123456789"; // 40 chars
+
+static double __bench_lines(comm_line_stream_t* writer, comm_line_stream_t* reader) {
+	uint64_t start = bench_now_ns();
+
+	for (uint32_t round = 0; round < __ROUNDS; round++) {
+		for (uint32_t i = 0; i < __LINES_PER_ROUND; i++)
+			comm_line_stream_write(writer, __line);
+
+		for (uint32_t i = 0; i < __LINES_PER_ROUND; i++)
+			comm_line_stream_read(reader);
+	}
+
+	uint64_t elapsed = bench_now_ns() - start;
+	return elapsed ? (double)__ROUNDS * __LINES_PER_ROUND * 1e9 / (double)elapsed : 0.0;
+}
+
+void bench_buffered_stream() {
+	int fds[2];
+
+	// Pipe rather than socketpair: unbuffered output sends one byte per system call, and socket
+	// buffers would be exhausted by per-send overhead long before a round is written
+	if (pipe(fds) != 0)
+		return;
+
+	comm_fd_stream_t* in  = comm_fd_stream_new(fds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* out = comm_fd_stream_new(fds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+
+	comm_buffered_stream_t* bufferedOut = comm_buffered_stream_new(out, 0, __BLOCK_SIZE, NULL, NULL);
+	comm_buffered_stream_t* bufferedIn  = comm_buffered_stream_new(in, __BLOCK_SIZE, 0, NULL, NULL);
+
+	comm_line_stream_t* rawWriter = comm_line_stream_new(out, 64, false, NULL, NULL);
+	comm_line_stream_t* rawReader = comm_line_stream_new(in, 64, true, NULL, NULL);
+	comm_line_stream_t* bufferedWriter = comm_line_stream_new(bufferedOut, 64, false, NULL, NULL);
+	comm_line_stream_t* bufferedReader = comm_line_stream_new(bufferedIn, 64, true, NULL, NULL);
+
+	BENCH_LOG("buffered_stream: 40-char lines over a pipe (%u lines)", __ROUNDS * __LINES_PER_ROUND);
+	BENCH_LOG("  unbuffered: %10.0f lines/s", __bench_lines(rawWriter, rawReader));
+	BENCH_LOG("  buffered  : %10.0f lines/s", __bench_lines(bufferedWriter, bufferedReader));
+
+	comm_obj_del(bufferedReader);
+	comm_obj_del(bufferedWriter);
+	comm_obj_del(rawReader);
+	comm_obj_del(rawWriter);
+	comm_obj_del(bufferedIn);
+	comm_obj_del(bufferedOut);
+	comm_obj_del(in);
+	comm_obj_del(out);
+}
+#else
+void bench_buffered_stream() {}
+#endif
@@ -0,0 +1,92 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dispatch.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#define __ITERATIONS 2000000
+#define __RUNS       5 // Best run is reported
+#define __MAX_DEPTH  3
+
+// Pass-through wrapper implemented through the public API (forwards to the stream in its data)
+static int32_t COMM_CALL __forward_read(comm_stream_t* stream, void* out, uint32_t len) {
+	return comm_stream_read(comm_obj_data(stream), out, len);
+}
+
+static int32_t COMM_CALL __forward_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	return comm_stream_write(comm_obj_data(stream), in, len);
+}
+
+static const comm_stream_controller_t __forwardController = {
+	.read  = __forward_read,
+	.write = __forward_write
+};
+
+static uint64_t __run(comm_stream_t* stream) {
+	uint8_t byte = 0;
+	uint64_t best = UINT64_MAX;
+
+	for (int run = 0; run < __RUNS; run++) {
+		uint64_t start = bench_now_ns();
+
+		for (uint32_t i = 0; i < __ITERATIONS; i++) {
+			comm_stream_write(stream, &byte, 1);
+			comm_stream_read(stream, &byte, 1);
+		}
+
+		uint64_t elapsed = bench_now_ns() - start;
+
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+void bench_dispatch() {
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_stream_t* builtIn[__MAX_DEPTH + 1] = { buffer };
+	comm_stream_t* forward[__MAX_DEPTH + 1] = { buffer };
+
+	// Built-in wrappers (line streams used as plain streams) and application-defined wrappers
+	for (int depth = 1; depth <= __MAX_DEPTH; depth++) {
+		builtIn[depth] = comm_line_stream_new(builtIn[depth - 1], 16, false, NULL, NULL);
+		forward[depth] = comm_stream_new(&__forwardController, forward[depth - 1]);
+	}
+
+	BENCH_LOG("dispatch: 1-byte write + read through N-deep wrapper chains over comm_buffer");
+
+	for (int depth = 0; depth <= __MAX_DEPTH; depth++) {
+		uint64_t builtInNs = __run(builtIn[depth]);
+		uint64_t forwardNs = __run(forward[depth]);
+
+		BENCH_LOG("  depth %d: built-in %5.1f ns/call | forwarding %5.1f ns/call", depth, builtInNs / (2.0 * __ITERATIONS), forwardNs / (2.0 * __ITERATIONS));
+	}
+
+	for (int depth = __MAX_DEPTH; depth > 0; depth--) {
+		comm_obj_del(forward[depth]);
+		comm_obj_del(builtIn[depth]);
+	}
+
+	comm_obj_del(buffer);
+}
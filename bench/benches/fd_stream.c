@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "fd_stream.h"
+#include "../bench.h"
+
+#include <comm.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define __TOTAL_BYTES (64u * 1024u * 1024u)
+#define __MAX_CHUNK   16384
+
+typedef struct {
+	int fds[2];
+	comm_stream_t* streams[2];
+} __pair_t;
+
+// Single-threaded ping: write one chunk on one end, read it back on the other.
+static uint64_t __bench_raw(__pair_t* pair, uint32_t chunk) {
+	static uint8_t data[__MAX_CHUNK];
+
+	uint64_t start = bench_now_ns();
+	for (uint32_t total = 0; total < __TOTAL_BYTES; total += chunk) {
+		if (write(pair->fds[0], data, chunk) != (ssize_t)chunk)
+			return 0;
+
+		for (uint32_t received = 0; received < chunk;) {
+			ssize_t result = read(pair->fds[1], data, chunk - received);
+			if (result <= 0)
+				return 0;
+			received += (uint32_t)result;
+		}
+	}
+
+	return bench_now_ns() - start;
+}
+
+static uint64_t __bench_stream(__pair_t* pair, uint32_t chunk) {
+	static uint8_t data[__MAX_CHUNK];
+
+	uint64_t start = bench_now_ns();
+	for (uint32_t total = 0; total < __TOTAL_BYTES; total += chunk) {
+		if (comm_stream_write(pair->streams[0], data, chunk) != (int32_t)chunk)
+			return 0;
+
+		for (uint32_t received = 0; received < chunk;) {
+			int32_t result = comm_stream_read(pair->streams[1], data, chunk - received);
+			if (result <= 0)
+				return 0;
+			received += (uint32_t)result;
+		}
+	}
+
+	return bench_now_ns() - start;
+}
+
+void bench_fd_stream() {
+	static const uint32_t chunks[] = { 16, 256, 4096, __MAX_CHUNK };
+	__pair_t pair;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair.fds) != 0)
+		return;
+
+	pair.streams[0] = comm_fd_stream_new(pair.fds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	pair.streams[1] = comm_fd_stream_new(pair.fds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+
+	BENCH_LOG("fd_stream: socketpair throughput (%u MB, write then read per chunk)", __TOTAL_BYTES / (1024u * 1024u));
+
+	for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+		uint64_t rawNs    = __bench_raw(&pair, chunks[i]);
+		uint64_t streamNs = __bench_stream(&pair, chunks[i]);
+
+		BENCH_LOG("  %5u B: raw %8.1f MB/s | stream %8.1f MB/s", chunks[i], bench_mb_per_s(__TOTAL_BYTES, rawNs), bench_mb_per_s(__TOTAL_BYTES, streamNs));
+	}
+
+	comm_obj_del(pair.streams[0]);
+	comm_obj_del(pair.streams[1]);
+}
@@ -0,0 +1,140 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "flush_policy.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define __MESSAGES     100000
+#define __MESSAGE_LEN  32
+#define __BLOCK_SIZE   4096
+#define __PACED_GAP_NS 20000
+
+typedef struct {
+	int      fd;
+	uint32_t count;
+	uint64_t* latencies;
+	uint64_t  lastNs;
+} __consumer_t;
+
+static void* __consume(void* arg) {
+	__consumer_t* consumer = arg;
+	comm_fd_stream_t* in = comm_fd_stream_new(consumer->fd, 0, NULL, NULL);
+	comm_buffered_stream_t* buffered = comm_buffered_stream_new(in, __BLOCK_SIZE, 0, NULL, NULL);
+	comm_packet_stream_t* packets = comm_packet_stream_new(buffered, true, NULL, NULL);
+	uint8_t len;
+
+	for (uint32_t i = 0; i < consumer->count; i++) {
+		uint8_t* packet = comm_packet_stream_read(packets, &len);
+		uint64_t sentNs;
+
+		if (!packet)
+			break;
+
+		memcpy(&sentNs, packet, sizeof(sentNs));
+		consumer->lastNs = bench_now_ns();
+		consumer->latencies[i] = consumer->lastNs - sentNs;
+	}
+
+	comm_obj_del(packets);
+	comm_obj_del(buffered);
+	comm_obj_del(in);
+	return NULL;
+}
+
+static int __compare(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+static void __bench_policy(const char* name, uint32_t policy, uint32_t param, bool paced) {
+	int fds[2];
+	pthread_t thread;
+	uint8_t message[__MESSAGE_LEN];
+	__consumer_t consumer = { .count = __MESSAGES };
+
+	if (pipe(fds) != 0)
+		return;
+
+	consumer.fd = fds[0];
+	consumer.latencies = calloc(__MESSAGES, sizeof(uint64_t));
+
+	comm_fd_stream_t* out = comm_fd_stream_new(fds[1], 0, NULL, NULL);
+	comm_buffered_stream_t* buffered = comm_buffered_stream_new(out, 0, __BLOCK_SIZE, NULL, NULL);
+	comm_packet_stream_t* packets = comm_packet_stream_new(buffered, false, NULL, NULL);
+
+	comm_buffered_stream_set_flush_policy(buffered, policy, param);
+	memset(message, 0, sizeof(message));
+
+	pthread_create(&thread, NULL, __consume, &consumer);
+
+	uint64_t start = bench_now_ns();
+	uint64_t next = start;
+
+	for (uint32_t i = 0; i < __MESSAGES; i++) {
+		if (paced) {
+			// Deferred output is serviced while idling
+			while (bench_now_ns() < next)
+				comm_buffered_stream_service(buffered, NULL);
+
+			next += __PACED_GAP_NS;
+		}
+
+		uint64_t now = bench_now_ns();
+		memcpy(message, &now, sizeof(now));
+		comm_packet_stream_write(packets, message, sizeof(message));
+		comm_buffered_stream_service(buffered, NULL);
+	}
+
+	comm_buffered_stream_sync(buffered);
+	pthread_join(thread, NULL);
+
+	qsort(consumer.latencies, __MESSAGES, sizeof(uint64_t), __compare);
+	BENCH_LOG("  %-10s %-6s: %10.0f msgs/s | p50 %8.1f us | p99 %8.1f us", name, paced ? "paced" : "burst", __MESSAGES * 1e9 / (double)(consumer.lastNs - start), consumer.latencies[__MESSAGES / 2] / 1e3, consumer.latencies[__MESSAGES * 99 / 100] / 1e3);
+
+	comm_obj_del(packets);
+	comm_obj_del(buffered);
+	comm_obj_del(out);
+	close(fds[0]);
+	close(fds[1]);
+	free(consumer.latencies);
+}
+
+void bench_flush_policy() {
+	BENCH_LOG("flush_policy: %d-byte packets over a pipe (paced: one every %d us)", __MESSAGE_LEN, __PACED_GAP_NS / 1000);
+
+	for (int paced = 0; paced < 2; paced++) {
+		__bench_policy("immediate", COMM_BUFFERED_STREAM_FLUSH_IMMEDIATE, 0, paced);
+		__bench_policy("threshold", COMM_BUFFERED_STREAM_FLUSH_THRESHOLD, 1024, paced);
+		__bench_policy("deadline", COMM_BUFFERED_STREAM_FLUSH_DEADLINE, 200, paced);
+		__bench_policy("adaptive", COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE, 10, paced);
+	}
+}
+#else
+void bench_flush_policy() {}
+#endif
@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "line_stream.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#include <string.h>
+
+#define __BUFFER_SIZE  65536
+#define __TOTAL_BYTES  (64u * 1024u * 1024u)
+#define __MAX_LINE_LEN 4096
+
+static void __bench_line_len(uint32_t lineLen) {
+	static char line[__MAX_LINE_LEN + 1];
+	comm_buffer_t* buffer = comm_buffer_new(__BUFFER_SIZE, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(buffer, __MAX_LINE_LEN, false, NULL, NULL);
+	uint32_t linesPerFill = __BUFFER_SIZE / (lineLen + 1);
+	uint64_t lines = 0;
+
+	memset(line, 'x', lineLen);
+	line[lineLen] = '\r';
+
+	uint64_t start = bench_now_ns();
+
+	while (lines * (lineLen + 1) < __TOTAL_BYTES) {
+		for (uint32_t i = 0; i < linesPerFill; i++)
+			comm_stream_write(buffer, line, lineLen + 1);
+
+		while (comm_line_stream_read(lineStream))
+			lines++;
+	}
+
+	uint64_t elapsed = bench_now_ns() - start;
+
+	BENCH_LOG("  %4u-byte lines: %10.0f lines/s | %8.1f MB/s", lineLen, lines * 1e9 / (double)elapsed, bench_mb_per_s(lines * (lineLen + 1), elapsed));
+
+	comm_obj_del(lineStream);
+	comm_obj_del(buffer);
+}
+
+void bench_line_stream() {
+	BENCH_LOG("line_stream: non-blocking line reads over comm_buffer");
+
+	__bench_line_len(16);
+	__bench_line_len(128);
+	__bench_line_len(4096 - 1);
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "packet_queue.h"
+#include "../bench.h"
+
+#include <comm.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define __PACKETS_PER_PRODUCER 1000000
+#define __PACKET_LEN           32
+#define __MAX_PRODUCERS        8
+
+static int32_t COMM_CALL __sink_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	(void)stream;
+	(void)in;
+	return len;
+}
+
+static const comm_stream_controller_t __sinkController = {
+	.write = __sink_write
+};
+
+typedef struct __args __args_t;
+
+struct __args {
+	comm_packet_queue_t*  queue;
+	comm_packet_stream_t* packetStream;
+	pthread_mutex_t*      mutex;
+};
+
+static void* __queue_producer(void* mArgs) {
+	__args_t* args = mArgs;
+	uint8_t packet[__PACKET_LEN] = { 0 };
+
+	for (uint32_t i = 0; i < __PACKETS_PER_PRODUCER; i++) {
+		while (!comm_packet_queue_push(args->queue, packet, sizeof(packet)))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void* __mutex_producer(void* mArgs) {
+	__args_t* args = mArgs;
+	uint8_t packet[__PACKET_LEN] = { 0 };
+
+	for (uint32_t i = 0; i < __PACKETS_PER_PRODUCER; i++) {
+		pthread_mutex_lock(args->mutex);
+		comm_packet_stream_write(args->packetStream, packet, sizeof(packet));
+		pthread_mutex_unlock(args->mutex);
+	}
+
+	return NULL;
+}
+
+static void __bench_producers(uint32_t producers) {
+	pthread_t threads[__MAX_PRODUCERS];
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	comm_stream_t* sink = comm_stream_new(&__sinkController, NULL);
+	uint64_t total = (uint64_t)producers * __PACKETS_PER_PRODUCER;
+	uint64_t start;
+	uint64_t queueNs;
+	uint64_t mutexNs;
+
+	__args_t args = {
+		.queue        = comm_packet_queue_new(sink, 1024, NULL, NULL),
+		.packetStream = comm_packet_stream_new(sink, false, NULL, NULL),
+		.mutex        = &mutex
+	};
+
+	// Lock-free queue drained by this thread
+	start = bench_now_ns();
+	for (uint32_t i = 0; i < producers; i++)
+		pthread_create(&threads[i], NULL, __queue_producer, &args);
+
+	uint64_t drained = 0;
+	while (drained < total) {
+		int32_t count = comm_packet_queue_drain(args.queue);
+
+		if (count == 0)
+			sched_yield();
+
+		drained += count;
+	}
+
+	for (uint32_t i = 0; i < producers; i++)
+		pthread_join(threads[i], NULL);
+	queueNs = bench_now_ns() - start;
+
+	// Packet stream shared under a mutex
+	start = bench_now_ns();
+	for (uint32_t i = 0; i < producers; i++)
+		pthread_create(&threads[i], NULL, __mutex_producer, &args);
+
+	for (uint32_t i = 0; i < producers; i++)
+		pthread_join(threads[i], NULL);
+	mutexNs = bench_now_ns() - start;
+
+	comm_obj_del(args.queue);
+	comm_obj_del(args.packetStream);
+	comm_obj_del(sink);
+
+	BENCH_LOG(
+		"  %u producer(s): queue %6.2f Mpackets/s | mutex %6.2f Mpackets/s",
+		producers,
+		(double)total / ((double)queueNs / 1e3),
+		(double)total / ((double)mutexNs / 1e3)
+	);
+}
+
+void bench_packet_queue() {
+	BENCH_LOG("packet_queue: fan-in throughput (%d-byte packets)", __PACKET_LEN);
+
+	for (uint32_t producers = 1; producers <= __MAX_PRODUCERS; producers *= 2)
+		__bench_producers(producers);
+}
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "reactor.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define __MAX_STREAMS 10000
+#define __ROUNDS      20
+
+typedef struct {
+	comm_fd_stream_t*     in;
+	comm_fd_stream_t*     out;
+	comm_stats_stream_t*  inStats;  // Counts reads issued on the descriptor
+	comm_stats_stream_t*  outStats; // Counts writes issued on the descriptor
+	comm_packet_stream_t* reader;
+	comm_packet_stream_t* writer;
+} __conn_t;
+
+static void COMM_CALL __on_packet(comm_packet_stream_t* packetStream, uint8_t* packet, uint8_t len, void* userData) {
+	(void)packetStream;
+	(void)packet;
+	(void)len;
+
+	(*(uint32_t*)userData)++;
+}
+
+// Clamps connection count to what the descriptor limit allows (two descriptors per connection)
+static uint32_t __max_conns() {
+	struct rlimit limit;
+	uint64_t conns = __MAX_STREAMS;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && (limit.rlim_cur - 64) / 2 < conns)
+		conns = limit.rlim_cur > 64 ? (limit.rlim_cur - 64) / 2 : 0;
+
+	return (uint32_t)conns;
+}
+
+static uint32_t __send_active(__conn_t* conns, uint32_t count, uint32_t active) {
+	for (uint32_t i = 0; i < active; i++)
+		comm_packet_stream_write(conns[(i * 7919u) % count].writer, "ping", 4);
+
+	return active;
+}
+
+// Each comm_reactor_run_once() call issues exactly one wait (epoll_wait or io_uring_enter, the
+// latter also submitting posted reads and writes), counted into 'calls'. Timing includes sending.
+static uint64_t __bench_reactor(comm_reactor_t* reactor, __conn_t* conns, uint32_t count, uint32_t active, uint64_t* calls) {
+	uint64_t elapsed = 0;
+
+	for (uint32_t round = 0; round < __ROUNDS; round++) {
+		uint64_t start = bench_now_ns();
+		uint32_t expected = __send_active(conns, count, active);
+		uint32_t frames = 0;
+
+		while (frames < expected) {
+			int32_t result = comm_reactor_run_once(reactor, 1000);
+			if (result < 0)
+				return 0;
+			frames += (uint32_t)result;
+			(*calls)++;
+		}
+		elapsed += bench_now_ns() - start;
+	}
+
+	return elapsed / __ROUNDS;
+}
+
+// Baseline: poll every connection looking for frames
+static uint64_t __bench_polling(__conn_t* conns, uint32_t count, uint32_t active) {
+	uint64_t elapsed = 0;
+	uint8_t len;
+
+	for (uint32_t round = 0; round < __ROUNDS; round++) {
+		uint64_t start = bench_now_ns();
+		uint32_t expected = __send_active(conns, count, active);
+		uint32_t frames = 0;
+
+		while (frames < expected) {
+			for (uint32_t i = 0; i < count; i++) {
+				while (comm_packet_stream_read(conns[i].reader, &len))
+					frames++;
+			}
+		}
+		elapsed += bench_now_ns() - start;
+	}
+
+	return elapsed / __ROUNDS;
+}
+
+// Reads and writes issued on descriptors (one system call each, unless an io_uring reactor performs
+// them). FIONREAD ioctls preceding epoll reads are not counted.
+static uint64_t __fd_calls(__conn_t* conns, uint32_t count) {
+	comm_stats_stream_snapshot_t snapshot;
+	uint64_t calls = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		comm_stats_stream_snapshot(conns[i].inStats, &snapshot);
+		calls += snapshot.read.calls;
+		comm_stats_stream_snapshot(conns[i].outStats, &snapshot);
+		calls += snapshot.write.calls;
+		comm_stats_stream_reset(conns[i].inStats);
+		comm_stats_stream_reset(conns[i].outStats);
+	}
+
+	return calls;
+}
+
+// Writers are registered as well, so that the io_uring backend submits their output
+static void __bench_backend(uint32_t backend, const char* name, __conn_t* conns, uint32_t count) {
+	static const uint32_t activePercent[] = { 1, 10, 100 };
+
+	uint32_t frames = 0;
+	comm_reactor_t* reactor = comm_reactor_new(backend, NULL, NULL);
+
+	if (!reactor) {
+		BENCH_LOG("  %-8s: not available", name);
+		return;
+	}
+
+	for (uint32_t c = 0; c < count; c++) {
+		comm_reactor_add_packet_stream(reactor, conns[c].reader, __on_packet, NULL, &frames);
+		comm_reactor_add_packet_stream(reactor, conns[c].writer, __on_packet, NULL, &frames);
+	}
+
+	for (size_t i = 0; i < sizeof(activePercent) / sizeof(activePercent[0]); i++) {
+		uint32_t active = count * activePercent[i] / 100;
+		active = active ? active : 1;
+
+		uint64_t waits = 0;
+		__fd_calls(conns, count);
+		uint64_t roundNs = __bench_reactor(reactor, conns, count, active, &waits);
+		uint64_t syscalls = waits + (backend == COMM_REACTOR_BACKEND_IO_URING ? 0 : __fd_calls(conns, count));
+		double msgs = (double)active * __ROUNDS;
+
+		BENCH_LOG("  %-8s %3u%% active (%5u streams): %10.1f us/round | %10.0f msgs/s | %.3f waits/msg | %.3f syscalls/msg", name, activePercent[i], active, roundNs / 1e3, roundNs ? active * 1e9 / roundNs : 0.0, waits / msgs, syscalls / msgs);
+	}
+
+	comm_obj_del(reactor);
+}
+
+void bench_reactor() {
+	static const uint32_t activePercent[] = { 1, 10, 100 };
+
+	uint32_t count = __max_conns();
+	__conn_t* conns = calloc(count, sizeof(__conn_t));
+
+	if (!conns)
+		return;
+
+	for (uint32_t i = 0; i < count; i++) {
+		int fds[2];
+
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+			count = i;
+			break;
+		}
+
+		conns[i].in       = comm_fd_stream_new(fds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+		conns[i].out      = comm_fd_stream_new(fds[1], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+		conns[i].inStats  = comm_stats_stream_new(conns[i].in, NULL, NULL);
+		conns[i].outStats = comm_stats_stream_new(conns[i].out, NULL, NULL);
+		conns[i].reader   = comm_packet_stream_new(conns[i].inStats, false, NULL, NULL);
+		conns[i].writer   = comm_packet_stream_new(conns[i].outStats, false, NULL, NULL);
+	}
+
+	BENCH_LOG("reactor: frame dispatch per round over %u socketpairs", count);
+
+	for (size_t i = 0; i < sizeof(activePercent) / sizeof(activePercent[0]); i++) {
+		uint32_t active = count * activePercent[i] / 100;
+		active = active ? active : 1;
+
+		uint64_t pollingNs = __bench_polling(conns, count, active);
+		BENCH_LOG("  polling  %3u%% active (%5u streams): %10.1f us/round", activePercent[i], active, pollingNs / 1e3);
+	}
+
+	__bench_backend(COMM_REACTOR_BACKEND_EPOLL, "epoll", conns, count);
+	__bench_backend(COMM_REACTOR_BACKEND_IO_URING, "io_uring", conns, count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		comm_obj_del(conns[i].reader);
+		comm_obj_del(conns[i].writer);
+		comm_obj_del(conns[i].inStats);
+		comm_obj_del(conns[i].outStats);
+		comm_obj_del(conns[i].in);
+		comm_obj_del(conns[i].out);
+	}
+
+	free(conns);
+}
+#else
+void bench_reactor() {}
+#endif
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "slab.h"
+#include "../bench.h"
+
+#include <comm/_slab.h>
+#include <stdlib.h>
+
+#define __BATCH      1024
+#define __ROUNDS     2000
+
+typedef void* (*__alloc_fn_t)(size_t size);
+typedef void (*__free_fn_t)(void* ptr);
+
+static double __bench_batch(__alloc_fn_t allocFn, __free_fn_t freeFn, size_t size) {
+	static void* ptrs[__BATCH];
+
+	uint64_t start = bench_now_ns();
+	for (uint32_t round = 0; round < __ROUNDS; round++) {
+		for (uint32_t i = 0; i < __BATCH; i++)
+			ptrs[i] = allocFn(size);
+
+		for (uint32_t i = 0; i < __BATCH; i++)
+			freeFn(ptrs[(i * 7) % __BATCH]); // Non-LIFO release order
+	}
+	uint64_t elapsed = bench_now_ns() - start;
+
+	return (double)elapsed / ((double)__ROUNDS * __BATCH);
+}
+
+void bench_slab() {
+	static const size_t sizes[] = { 64, 320, 1024, 4096 };
+
+	BENCH_LOG("slab: alloc+free cost (batches of %d blocks)", __BATCH);
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		double mallocNs = __bench_batch(malloc, free, sizes[i]);
+		double slabNs   = __bench_batch(_comm_slab_alloc, _comm_slab_free, sizes[i]);
+
+		BENCH_LOG("  %5zu B: malloc %6.1f ns | slab %6.1f ns", sizes[i], mallocNs, slabNs);
+	}
+
+	_comm_slab_trim();
+}
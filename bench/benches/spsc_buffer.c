@@ -0,0 +1,209 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "spsc_buffer.h"
+#include "../bench.h"
+
+#include <comm.h>
+#include <comm/_obj.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define __CAPACITY      (64 * 1024)
+#define __TOTAL_SIZE    (256 * 1024 * 1024)
+#define __PING_PONGS    100000
+#define __IDLE_PACKETS  100
+#define __IDLE_PERIOD_US 2000
+
+typedef struct __throughput_args __throughput_args_t;
+
+struct __throughput_args {
+	comm_stream_t* stream;
+	uint32_t       chunkSize;
+	uint64_t       total;
+};
+
+static void* __producer(void* mArgs) {
+	__throughput_args_t* args = mArgs;
+	static uint8_t in[16 * 1024];
+	uint64_t remaining = args->total;
+
+	while (remaining) {
+		uint32_t len = remaining < args->chunkSize ? (uint32_t)remaining : args->chunkSize;
+		int32_t written = comm_stream_write(args->stream, in, len);
+
+		if (written == 0) {
+			sched_yield();
+		} else {
+			remaining -= written;
+		}
+	}
+
+	return NULL;
+}
+
+static void __consume(__throughput_args_t* args) {
+	static uint8_t out[16 * 1024];
+	uint64_t remaining = args->total;
+
+	while (remaining) {
+		int32_t read = comm_stream_read(args->stream, out, args->chunkSize);
+
+		if (read == 0) {
+			sched_yield();
+		} else {
+			remaining -= read;
+		}
+	}
+}
+
+static void __bench_throughput() {
+	BENCH_LOG("spsc_buffer: two-thread throughput");
+
+	for (uint32_t chunkSize = 16; chunkSize <= 16 * 1024; chunkSize *= 4) {
+		pthread_t thread;
+		__throughput_args_t args = {
+			.stream    = comm_spsc_buffer_new_mirrored(__CAPACITY, NULL, NULL),
+			.chunkSize = chunkSize,
+			.total     = __TOTAL_SIZE
+		};
+
+		uint64_t start = bench_now_ns();
+		pthread_create(&thread, NULL, __producer, &args);
+		__consume(&args);
+		pthread_join(thread, NULL);
+		uint64_t elapsed = bench_now_ns() - start;
+
+		comm_obj_del(args.stream);
+
+		BENCH_LOG("  %6u B: %9.1f MB/s", chunkSize, bench_mb_per_s(__TOTAL_SIZE, elapsed));
+	}
+}
+
+typedef struct __ping_pong_args __ping_pong_args_t;
+
+struct __ping_pong_args {
+	comm_stream_t* ping;
+	comm_stream_t* pong;
+};
+
+static void __transfer(comm_stream_t* from, comm_stream_t* to, uint64_t* value) {
+	while (comm_stream_read(from, value, sizeof(*value)) == 0)
+		sched_yield();
+
+	while (comm_stream_write(to, value, sizeof(*value)) == 0)
+		sched_yield();
+}
+
+static void* __echo(void* mArgs) {
+	__ping_pong_args_t* args = mArgs;
+	uint64_t value;
+
+	for (uint32_t i = 0; i < __PING_PONGS; i++)
+		__transfer(args->ping, args->pong, &value);
+
+	return NULL;
+}
+
+static void __bench_latency() {
+	pthread_t thread;
+	__ping_pong_args_t args = {
+		.ping = comm_spsc_buffer_new(4096, NULL, NULL),
+		.pong = comm_spsc_buffer_new(4096, NULL, NULL)
+	};
+
+	pthread_create(&thread, NULL, __echo, &args);
+
+	uint64_t start = bench_now_ns();
+	for (uint64_t i = 0; i < __PING_PONGS; i++) {
+		uint64_t value = i;
+
+		while (comm_stream_write(args.ping, &value, sizeof(value)) == 0)
+			sched_yield();
+
+		while (comm_stream_read(args.pong, &value, sizeof(value)) == 0)
+			sched_yield();
+	}
+	uint64_t elapsed = bench_now_ns() - start;
+
+	pthread_join(thread, NULL);
+	comm_obj_del(args.ping);
+	comm_obj_del(args.pong);
+
+	BENCH_LOG("spsc_buffer: one-way latency (ping-pong / 2): %.1f ns", (double)elapsed / __PING_PONGS / 2.0);
+}
+
+static void* __slow_producer(void* mStream) {
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(mStream, true, NULL, NULL);
+
+	for (uint32_t i = 0; i < __IDLE_PACKETS; i++) {
+		usleep(__IDLE_PERIOD_US);
+		comm_packet_stream_write(packetStream, &i, sizeof(i));
+	}
+
+	comm_obj_del(packetStream);
+	return NULL;
+}
+
+static double __bench_idle_cpu(bool waits) {
+	comm_spsc_buffer_t* buffer = comm_spsc_buffer_new(4096, NULL, NULL);
+	comm_stream_controller_t controller = *(const comm_stream_controller_t*)buffer->controller;
+
+	if (!waits) {
+		controller.wait_readable = NULL;
+		controller.wait_writable = NULL;
+		buffer->controller = (const comm_obj_controller_t*)&controller;
+	}
+
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(buffer, true, NULL, NULL);
+	pthread_t thread;
+	struct timespec start;
+	struct timespec end;
+
+	pthread_create(&thread, NULL, __slow_producer, buffer);
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+	for (uint32_t i = 0; i < __IDLE_PACKETS; i++)
+		comm_packet_stream_read(packetStream, NULL);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+
+	pthread_join(thread, NULL);
+	comm_obj_del(packetStream);
+	comm_obj_del(buffer);
+
+	double cpuNs = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+	return 100.0 * cpuNs / ((double)__IDLE_PACKETS * __IDLE_PERIOD_US * 1000.0);
+}
+
+static void __bench_idle() {
+	BENCH_LOG("spsc_buffer: blocking reader CPU usage (one packet every %d us)", __IDLE_PERIOD_US);
+	BENCH_LOG("  polling: %5.1f %%", __bench_idle_cpu(false));
+	BENCH_LOG("  waiting: %5.1f %%", __bench_idle_cpu(true));
+}
+
+void bench_spsc_buffer() {
+	__bench_throughput();
+	__bench_latency();
+	__bench_idle();
+}
@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stats_stream.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#define __ITERATIONS 2000000
+#define __BUFFER_LEN 4096
+
+static uint64_t __run(comm_stream_t* stream, uint32_t len) {
+	static uint8_t data[__BUFFER_LEN];
+	uint64_t start = bench_now_ns();
+
+	for (uint32_t i = 0; i < __ITERATIONS; i++) {
+		comm_stream_write(stream, data, len);
+		comm_stream_read(stream, data, len);
+	}
+
+	return bench_now_ns() - start;
+}
+
+void bench_stats_stream() {
+	static const uint32_t lengths[] = { 16, 256, 4096 };
+	comm_buffer_t* buffer = comm_buffer_new(__BUFFER_LEN, NULL, NULL);
+	comm_stats_stream_t* stats = comm_stats_stream_new(buffer, NULL, NULL);
+
+	BENCH_LOG("stats_stream: write + read round trips over comm_buffer");
+
+	for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		uint64_t directNs = __run(buffer, lengths[i]);
+		uint64_t statsNs = __run(stats, lengths[i]);
+
+		BENCH_LOG("  %4u bytes: direct %6.1f ns/op | stats %6.1f ns/op", lengths[i], (double)directNs / __ITERATIONS, (double)statsNs / __ITERATIONS);
+	}
+
+	comm_obj_del(stats);
+	comm_obj_del(buffer);
+}
@@ -0,0 +1,172 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_copy.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define __TOTAL_BYTES (64u * 1024u * 1024u)
+#define __CHUNK_LEN   65536
+
+#define __MIN_CHUNK(total) (__TOTAL_BYTES - (total) < __CHUNK_LEN ? __TOTAL_BYTES - (total) : __CHUNK_LEN)
+
+typedef struct {
+	int  fd;
+	bool produce; // Otherwise consumes
+} __peer_t;
+
+static void* __run_peer(void* arg) {
+	__peer_t* peer = arg;
+	static uint8_t produceBuf[__CHUNK_LEN];
+	uint8_t* buf = peer->produce ? produceBuf : malloc(__CHUNK_LEN);
+
+	for (uint32_t total = 0; total < __TOTAL_BYTES;) {
+		ssize_t result = peer->produce ? write(peer->fd, buf, __MIN_CHUNK(total)) : read(peer->fd, buf, __CHUNK_LEN);
+
+		if (result <= 0)
+			break;
+
+		total += (uint32_t)result;
+	}
+
+	if (!peer->produce)
+		free(buf);
+
+	return NULL;
+}
+
+// Hand-written relay through a user-space bounce buffer
+static void __relay_bounce(comm_stream_t* src, comm_stream_t* dst) {
+	static uint8_t bounce[__CHUNK_LEN];
+
+	for (uint32_t total = 0; total < __TOTAL_BYTES;) {
+		int32_t read = comm_stream_read(src, bounce, __MIN_CHUNK(total));
+
+		if (read <= 0)
+			return;
+
+		for (int32_t offset = 0; offset < read;) {
+			int32_t written = comm_stream_write(dst, bounce + offset, (uint32_t)(read - offset));
+
+			if (written <= 0)
+				return;
+
+			offset += written;
+		}
+
+		total += (uint32_t)read;
+	}
+}
+
+static void __relay_copy(comm_stream_t* src, comm_stream_t* dst) {
+	for (uint64_t total = 0; total < __TOTAL_BYTES;) {
+		if (!comm_stream_wait_readable(src, COMM_STREAM_WAIT_FOREVER))
+			return;
+
+		int64_t moved = comm_stream_copy(src, dst, __TOTAL_BYTES - total);
+
+		if (moved < 0)
+			return;
+
+		total += (uint64_t)moved;
+	}
+}
+
+static comm_fd_stream_t* __source_file() {
+	static uint8_t chunk[__CHUNK_LEN];
+	FILE* file = tmpfile();
+
+	if (!file)
+		return NULL;
+
+	for (uint32_t total = 0; total < __TOTAL_BYTES; total += sizeof(chunk))
+		fwrite(chunk, 1, sizeof(chunk), file);
+
+	fflush(file);
+	rewind(file);
+
+	comm_fd_stream_t* stream = comm_fd_stream_new(dup(fileno(file)), COMM_FD_STREAM_CLOSE, NULL, NULL);
+	fclose(file);
+	return stream;
+}
+
+static double __bench_relay(bool fromFile, bool useCopy) {
+	int in[2], out[2];
+	pthread_t producer, consumer;
+	comm_fd_stream_t* src;
+
+	socketpair(AF_UNIX, SOCK_STREAM, 0, in);
+	socketpair(AF_UNIX, SOCK_STREAM, 0, out);
+
+	__peer_t producerPeer = { .fd = in[0], .produce = true };
+	__peer_t consumerPeer = { .fd = out[1], .produce = false };
+
+	src = fromFile ? __source_file() : comm_fd_stream_new(in[1], 0, NULL, NULL);
+	comm_fd_stream_t* dst = comm_fd_stream_new(out[0], 0, NULL, NULL);
+
+	uint64_t start = bench_now_ns();
+
+	if (!fromFile)
+		pthread_create(&producer, NULL, __run_peer, &producerPeer);
+
+	pthread_create(&consumer, NULL, __run_peer, &consumerPeer);
+
+	if (useCopy) {
+		__relay_copy(src, dst);
+	} else {
+		__relay_bounce(src, dst);
+	}
+
+	pthread_join(consumer, NULL);
+
+	if (!fromFile)
+		pthread_join(producer, NULL);
+
+	uint64_t elapsed = bench_now_ns() - start;
+
+	comm_obj_del(dst);
+	comm_obj_del(src);
+
+	for (int i = 0; i < 2; i++) {
+		close(in[i]);
+		close(out[i]);
+	}
+
+	return bench_mb_per_s(__TOTAL_BYTES, elapsed);
+}
+
+void bench_stream_copy() {
+	BENCH_LOG("stream_copy: relay throughput (%u MB)", __TOTAL_BYTES / (1024u * 1024u));
+	BENCH_LOG("  file   -> socket: bounce %8.1f MB/s | comm_stream_copy %8.1f MB/s", __bench_relay(true, false), __bench_relay(true, true));
+	BENCH_LOG("  socket -> socket: bounce %8.1f MB/s | comm_stream_copy %8.1f MB/s", __bench_relay(false, false), __bench_relay(false, true));
+}
+#else
+void bench_stream_copy() {}
+#endif
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "tee_stream.h"
+#include "../bench.h"
+
+#include <comm.h>
+
+#include <string.h>
+
+#define __PACKETS     200000
+#define __PACKET_LEN  64
+#define __SINK_SIZE   (__PACKET_LEN + 1)
+#define __MAX_SINKS   16
+
+// Each packet is framed once per sink
+static uint64_t __per_sink(comm_buffer_t** sinks, uint32_t count, const uint8_t* packet) {
+	comm_packet_stream_t* streams[__MAX_SINKS];
+
+	for (uint32_t i = 0; i < count; i++)
+		streams[i] = comm_packet_stream_new(sinks[i], false, NULL, NULL);
+
+	uint64_t start = bench_now_ns();
+
+	for (uint32_t n = 0; n < __PACKETS; n++) {
+		for (uint32_t i = 0; i < count; i++) {
+			comm_packet_stream_write(streams[i], packet, __PACKET_LEN);
+			comm_stream_read(sinks[i], NULL, __SINK_SIZE);
+		}
+	}
+
+	uint64_t elapsed = bench_now_ns() - start;
+
+	for (uint32_t i = 0; i < count; i++)
+		comm_obj_del(streams[i]);
+
+	return elapsed;
+}
+
+// Each packet is framed once and fanned out
+static uint64_t __tee(comm_buffer_t** sinks, uint32_t count, const uint8_t* packet) {
+	comm_tee_stream_t* tee = comm_tee_stream_new(NULL, NULL);
+	comm_packet_stream_t* stream = comm_packet_stream_new(tee, false, NULL, NULL);
+
+	for (uint32_t i = 0; i < count; i++)
+		comm_tee_stream_add_sink(tee, sinks[i], COMM_TEE_STREAM_DROP, 0);
+
+	uint64_t start = bench_now_ns();
+
+	for (uint32_t n = 0; n < __PACKETS; n++) {
+		comm_packet_stream_write(stream, packet, __PACKET_LEN);
+
+		for (uint32_t i = 0; i < count; i++)
+			comm_stream_read(sinks[i], NULL, __SINK_SIZE);
+	}
+
+	uint64_t elapsed = bench_now_ns() - start;
+
+	comm_obj_del(stream);
+	comm_obj_del(tee);
+	return elapsed;
+}
+
+void bench_tee_stream() {
+	static const uint32_t sinkCounts[] = { 1, 4, 16 };
+	comm_buffer_t* sinks[__MAX_SINKS];
+	uint8_t packet[__PACKET_LEN];
+
+	memset(packet, 0x5a, sizeof(packet));
+
+	for (uint32_t i = 0; i < __MAX_SINKS; i++)
+		sinks[i] = comm_buffer_new(__SINK_SIZE * 4, NULL, NULL);
+
+	BENCH_LOG("tee_stream: %d-byte packets broadcast to N in-memory sinks", __PACKET_LEN);
+
+	for (uint32_t c = 0; c < sizeof(sinkCounts) / sizeof(sinkCounts[0]); c++) {
+		uint32_t count = sinkCounts[c];
+		uint64_t perSinkNs = __per_sink(sinks, count, packet);
+		uint64_t teeNs = __tee(sinks, count, packet);
+
+		BENCH_LOG("  N=%-2u per-sink: %7.1f ns/packet | tee: %7.1f ns/packet", count, (double)perSinkNs / __PACKETS, (double)teeNs / __PACKETS);
+	}
+
+	for (uint32_t i = 0; i < __MAX_SINKS; i++)
+		comm_obj_del(sinks[i]);
+}
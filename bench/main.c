@@ -0,0 +1,52 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "benches/buffer.h"
+#include "benches/dispatch.h"
+#include "benches/line_stream.h"
+#include "benches/spsc_buffer.h"
+#include "benches/packet_queue.h"
+#include "benches/slab.h"
+#include "benches/fd_stream.h"
+#include "benches/stream_copy.h"
+#include "benches/buffered_stream.h"
+#include "benches/flush_policy.h"
+#include "benches/tee_stream.h"
+#include "benches/stats_stream.h"
+#include "benches/reactor.h"
+
+int main() {
+	bench_buffer();
+	bench_dispatch();
+	bench_line_stream();
+	bench_spsc_buffer();
+	bench_packet_queue();
+	bench_slab();
+	bench_fd_stream();
+	bench_stream_copy();
+	bench_buffered_stream();
+	bench_flush_policy();
+	bench_tee_stream();
+	bench_stats_stream();
+	bench_reactor();
+
+	return 0;
+}
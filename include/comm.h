@@ -21,6 +21,15 @@ SOFTWARE.
 */
 #pragma once
 
+#include "comm/mem.h"
 #include "comm/line_stream.h"
 #include "comm/packet_stream.h"
+#include "comm/packet_queue.h"
 #include "comm/buffer.h"
+#include "comm/spsc_buffer.h"
+#include "comm/chain_buffer.h"
+#include "comm/buffered_stream.h"
+#include "comm/tee_stream.h"
+#include "comm/stats_stream.h"
+#include "comm/fd_stream.h"
+#include "comm/reactor.h"
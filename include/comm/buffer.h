@@ -25,19 +25,77 @@ SOFTWARE.
 
 typedef comm_stream_t         comm_buffer_t;
 typedef comm_obj_controller_t comm_buffer_controller_t;
+typedef struct comm_buffer_span comm_buffer_span_t;
+
+struct comm_buffer_span {
+	uint8_t* data;
+	size_t   len;
+};
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Creates a ring buffer with given capacity (plain heap storage). */
 COMM_PUBLIC comm_buffer_t* COMM_CALL comm_buffer_new(size_t capacity, const comm_buffer_controller_t* controller, void* data);
 
+/**
+ * Creates a ring buffer backed by a mirrored mapping (same pages mapped twice back to back), so
+ * readable and writable regions are always contiguous.
+ *
+ * Mirrored storage costs a file descriptor while the mapping is created and twice the address
+ * space, so it is only worth it for large buffers whose spans are used directly. It requires
+ * platform support (Linux) and a capacity which is a multiple of the page size: otherwise the
+ * buffer silently uses plain heap storage, as comm_buffer_new() does.
+ */
+COMM_PUBLIC comm_buffer_t* COMM_CALL comm_buffer_new_mirrored(size_t capacity, const comm_buffer_controller_t* controller, void* data);
+
 COMM_PUBLIC bool COMM_CALL comm_buffer_set_storage(comm_buffer_t* buffer, uint8_t* storage, size_t capacity, bool empty);
 
 COMM_PUBLIC size_t COMM_CALL comm_buffer_capacity(const comm_buffer_t* buffer);
 
 COMM_PUBLIC void COMM_CALL comm_buffer_clear(comm_buffer_t* buffer);
 
+/**
+ * Exposes the free region of the buffer as up to two contiguous spans (the second one is
+ * used only when the region wraps around the end of the storage).
+ *
+ * Data written into the spans becomes readable after comm_buffer_write_commit().
+ *
+ * @return Total number of bytes available through the spans.
+ */
+COMM_PUBLIC size_t COMM_CALL comm_buffer_write_acquire(comm_buffer_t* buffer, comm_buffer_span_t spans[2]);
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_write_commit(comm_buffer_t* buffer, size_t len);
+
+/**
+ * Exposes the readable region of the buffer as up to two contiguous spans without consuming it.
+ *
+ * Peeked data is consumed by comm_buffer_read_release().
+ *
+ * @return Total number of bytes available through the spans.
+ */
+COMM_PUBLIC size_t COMM_CALL comm_buffer_read_peek(const comm_buffer_t* buffer, comm_buffer_span_t spans[2]);
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_read_release(comm_buffer_t* buffer, size_t len);
+
+/**
+ * Searches buffered data for a byte without consuming it.
+ *
+ * @param offsetOut If not NULL, receives the offset (relative to the next byte to be read) of the
+ *        first occurrence.
+ *
+ * @return true if the byte was found, otherwise false.
+ */
+COMM_PUBLIC bool COMM_CALL comm_buffer_find(const comm_buffer_t* buffer, uint8_t byte, size_t* offsetOut);
+
+/**
+ * Searches buffered data for a multi-byte pattern without consuming it.
+ *
+ * @see comm_buffer_find()
+ */
+COMM_PUBLIC bool COMM_CALL comm_buffer_find_pattern(const comm_buffer_t* buffer, const void* pattern, size_t len, size_t* offsetOut);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+/** comm_stream_flush() transfers buffered output right away (default). */
+#define COMM_BUFFERED_STREAM_FLUSH_IMMEDIATE 0
+
+/** comm_stream_flush() is deferred until at least 'param' bytes are buffered. */
+#define COMM_BUFFERED_STREAM_FLUSH_THRESHOLD 1
+
+/** comm_stream_flush() is deferred until oldest buffered byte is 'param' microseconds old. */
+#define COMM_BUFFERED_STREAM_FLUSH_DEADLINE  2
+
+/**
+ * comm_stream_flush() transfers output right away if nothing was transferred during the last
+ * 'param' microseconds (idle link), otherwise it is deferred as in COMM_BUFFERED_STREAM_FLUSH_DEADLINE
+ * (busy link), so that output is batched under load only.
+ */
+#define COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE  3
+
+typedef comm_stream_t         comm_buffered_stream_t;
+typedef comm_obj_controller_t comm_buffered_stream_controller_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a stream wrapper which coalesces writes into a block (written into 'wrapped' when the
+ * stream is flushed or when the block is full), and serves reads from a read-ahead block filled
+ * by a single read of 'wrapped'.
+ *
+ * Buffered output is discarded when the stream is deleted without being flushed.
+ *
+ * @param readBufferSize  Read-ahead block size (0 disables read-ahead).
+ * @param writeBufferSize Write block size (0 disables write coalescing).
+ */
+COMM_PUBLIC comm_buffered_stream_t* COMM_CALL comm_buffered_stream_new(comm_stream_t* wrapped, uint32_t readBufferSize, uint32_t writeBufferSize, const comm_buffered_stream_controller_t* controller, void* data);
+
+/**
+ * Sets the policy applied when the stream is flushed (COMM_BUFFERED_STREAM_FLUSH_* values).
+ *
+ * Deferred output is transferred once a later flush is due, when the write block is full, or
+ * by comm_buffered_stream_service()/comm_buffered_stream_sync(). With deadline-based policies,
+ * writes also transfer output whose deadline has passed.
+ *
+ * Timers are not involved: output deferred by COMM_BUFFERED_STREAM_FLUSH_DEADLINE or
+ * COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE stays buffered past its deadline if nothing writes to,
+ * flushes or services the stream. Applications using these policies must therefore call
+ * comm_buffered_stream_service() when the stream goes quiet (e.g. from their event loop, using
+ * the returned wait time as timeout).
+ */
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_set_flush_policy(comm_buffered_stream_t* stream, uint32_t policy, uint32_t param);
+
+/**
+ * Transfers deferred output if its flush is due. Deadline-based policies require this function to
+ * be called once the returned wait time elapses when no other writes or flushes happen.
+ *
+ * @param waitUsOut If not NULL, receives the time (in microseconds) until the next deferred flush
+ *                  is due (UINT32_MAX if there is nothing to wait for).
+ */
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_service(comm_buffered_stream_t* stream, uint32_t* waitUsOut);
+
+/** Transfers all buffered output and flushes the wrapped stream, regardless of the flush policy. */
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_sync(comm_buffered_stream_t* stream);
+
+/** @return Number of written bytes not yet transferred into the wrapped stream. */
+COMM_PUBLIC uint32_t COMM_CALL comm_buffered_stream_pending(const comm_buffered_stream_t* stream);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
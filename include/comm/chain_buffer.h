@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+typedef comm_stream_t         comm_chain_buffer_t;
+typedef comm_obj_controller_t comm_chain_buffer_controller_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates an elastic buffer made of a list of fixed-size chunks.
+ *
+ * Chunks are appended as data is written and released as they are drained, so buffered bytes
+ * are never moved. Released chunks are kept for reuse in a bounded free list (see
+ * comm_chain_buffer_set_max_spare()).
+ *
+ * @param chunkSize Size of each chunk.
+ * @param maxSize Maximum number of buffered bytes (zero means no limit).
+ */
+COMM_PUBLIC comm_chain_buffer_t* COMM_CALL comm_chain_buffer_new(size_t chunkSize, size_t maxSize, const comm_chain_buffer_controller_t* controller, void* data);
+
+COMM_PUBLIC size_t COMM_CALL comm_chain_buffer_size(const comm_chain_buffer_t* buffer);
+
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_clear(comm_chain_buffer_t* buffer);
+
+/**
+ * Sets how many released chunks are kept for reuse instead of being freed (one by default).
+ * Larger values avoid allocations when the buffered size swings by several chunks, at the cost
+ * of idle memory. Spare chunks beyond the new limit are freed.
+ */
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_set_max_spare(comm_chain_buffer_t* buffer, size_t maxSpare);
+
+/**
+ * Allocates the chunks needed to write 'len' more bytes, so that such writes cannot fail for lack
+ * of memory (up to the limit set by 'maxSize'). Reserved chunks left unused beyond the spare
+ * limit are freed by the next read, write or comm_chain_buffer_clear().
+ */
+COMM_PUBLIC bool COMM_CALL comm_chain_buffer_reserve(comm_chain_buffer_t* buffer, size_t len);
+
+/**
+ * Discards the most recently written bytes, so that at most 'size' bytes remain buffered.
+ */
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_truncate(comm_chain_buffer_t* buffer, size_t size);
+
+/**
+ * Describes buffered data (without consuming it) as up to 'count' regions, in order. Described
+ * data can then be consumed with comm_stream_read(buffer, NULL, len).
+ *
+ * @return Number of filled regions.
+ */
+COMM_PUBLIC uint32_t COMM_CALL comm_chain_buffer_peek(const comm_chain_buffer_t* buffer, comm_stream_vec_t* vec, uint32_t count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -27,3 +27,4 @@ SOFTWARE.
 #define COMM_ERROR_NOMEM    -1
 #define COMM_ERROR_IO       -2
 #define COMM_ERROR_INVPARAM -3
+#define COMM_ERROR_AGAIN    -4
@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+/** Puts the file descriptor in non-blocking mode (reads/writes return 0 instead of blocking). */
+#define COMM_FD_STREAM_NONBLOCK 0x01
+
+/** Closes the file descriptor when the stream is deleted. */
+#define COMM_FD_STREAM_CLOSE    0x02
+
+typedef comm_stream_t         comm_fd_stream_t;
+typedef comm_obj_controller_t comm_fd_stream_controller_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a stream over a POSIX file descriptor (pipe, socket, tty, file...).
+ *
+ * Reaching end-of-file is reported as a read error. Available on POSIX platforms only: elsewhere
+ * NULL is returned with errno set to COMM_ERROR_INVPARAM.
+ *
+ * @param flags Combination of COMM_FD_STREAM_* flags.
+ */
+COMM_PUBLIC comm_fd_stream_t* COMM_CALL comm_fd_stream_new(int fd, uint32_t flags, const comm_fd_stream_controller_t* controller, void* data);
+
+/** @return File descriptor of given stream, or -1 if stream is not a (still open) fd stream. */
+COMM_PUBLIC int COMM_CALL comm_fd_stream_fd(const comm_stream_t* stream);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
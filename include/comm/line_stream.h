@@ -32,8 +32,38 @@ extern "C" {
 
 COMM_PUBLIC comm_line_stream_t* COMM_CALL comm_line_stream_new(comm_stream_t* wrapped, size_t lineMaxLen, bool blockRead, const comm_line_stream_controller_t* controller, void* data);
 
+/**
+ * Writes a line. With non-blocking writes (see comm_line_stream_set_block_write()), the part of the
+ * line not accepted right away by the wrapped stream is queued and true is returned.
+ *
+ * @return false on error, or (with non-blocking writes) with errno set to COMM_ERROR_AGAIN if the
+ *         line does not fit into the pending buffer (in which case nothing is written).
+ */
 COMM_PUBLIC bool COMM_CALL comm_line_stream_write(comm_line_stream_t* lineStream, const char* msg);
 
+/**
+ * Sets whether writes wait for the wrapped stream to accept all data (default).
+ *
+ * With non-blocking writes, output not accepted by the wrapped stream is kept in a pending buffer
+ * and written by subsequent writes and flushes (comm_stream_flush() is meant to be called once the
+ * wrapped stream becomes writable, as comm_reactor does).
+ *
+ * @param maxPending Maximum size of the pending buffer (zero means no limit).
+ */
+COMM_PUBLIC void COMM_CALL comm_line_stream_set_block_write(comm_line_stream_t* lineStream, bool blockWrite, size_t maxPending);
+
+/** @return Number of bytes waiting to be written into the wrapped stream. */
+COMM_PUBLIC size_t COMM_CALL comm_line_stream_pending(const comm_line_stream_t* lineStream);
+
+/**
+ * Reads a line (without its delimiter). Lines longer than lineMaxLen are truncated.
+ *
+ * Data is read from the wrapped stream in chunks: bytes following the returned line are kept for
+ * subsequent calls, so the wrapped stream must not be read directly while lines are being read.
+ *
+ * @return The line (valid until the next call), or NULL if there is no complete line yet (with
+ *         non-blocking reads) or on error.
+ */
 COMM_PUBLIC char* COMM_CALL comm_line_stream_read(comm_line_stream_t* lineStream);
 
 #ifdef __cplusplus
@@ -0,0 +1,62 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+typedef comm_obj_t            comm_packet_queue_t;
+typedef comm_obj_controller_t comm_packet_queue_controller_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a bounded multi-producer/single-consumer packet queue draining into 'wrapped'.
+ *
+ * Packets are framed as in comm_packet_stream (length header followed by payload).
+ *
+ * @param slots Maximum number of queued packets. It must be a non-zero power of two.
+ */
+COMM_PUBLIC comm_packet_queue_t* COMM_CALL comm_packet_queue_new(comm_stream_t* wrapped, size_t slots, const comm_packet_queue_controller_t* controller, void* data);
+
+/**
+ * Enqueues a whole packet. This function can be called concurrently from multiple threads.
+ *
+ * @return true if packet was enqueued, or false (with errno set to COMM_ERROR_AGAIN) if queue is full.
+ */
+COMM_PUBLIC bool COMM_CALL comm_packet_queue_push(comm_packet_queue_t* queue, const void* in, uint8_t len);
+
+/**
+ * Writes queued packets into the wrapped stream, stopping when the queue is empty or when the
+ * wrapped stream does not accept more data (a partially written packet is resumed on next call).
+ * Only one thread at a time may drain the queue. The wrapped stream is flushed whenever data was
+ * written into it.
+ *
+ * @return Number of packets completely written. If the wrapped stream fails, packets written so
+ *         far are still reported and errno is set to COMM_ERROR_IO.
+ */
+COMM_PUBLIC int32_t COMM_CALL comm_packet_queue_drain(comm_packet_queue_t* queue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
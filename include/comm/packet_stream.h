@@ -32,8 +32,32 @@ extern "C" {
 
 COMM_PUBLIC comm_packet_stream_t* COMM_CALL comm_packet_stream_new(comm_stream_t* wrapped, bool blockRead, const comm_packet_stream_controller_t* controller, void* data);
 
+/**
+ * Writes a packet. With non-blocking writes (see comm_packet_stream_set_block_write()), the part of
+ * the packet not accepted right away by the wrapped stream is queued and true is returned.
+ *
+ * @return false on error, or (with non-blocking writes) with errno set to COMM_ERROR_AGAIN if the
+ *         packet does not fit into the pending buffer (in which case nothing is written).
+ */
 COMM_PUBLIC bool COMM_CALL comm_packet_stream_write(comm_packet_stream_t* packetStream, const void* in, uint8_t len);
 
+/**
+ * Writes multiple packets (each one described by a region of at most 255 bytes) using gather
+ * writes on the wrapped stream, followed by a single flush. With non-blocking writes, the batch is
+ * either written/queued or refused as a whole.
+ */
+COMM_PUBLIC bool COMM_CALL comm_packet_stream_write_batch(comm_packet_stream_t* packetStream, const comm_stream_vec_t* packets, uint32_t count);
+
+/**
+ * Sets whether writes wait for the wrapped stream to accept all data (default).
+ *
+ * @see comm_line_stream_set_block_write()
+ */
+COMM_PUBLIC void COMM_CALL comm_packet_stream_set_block_write(comm_packet_stream_t* packetStream, bool blockWrite, size_t maxPending);
+
+/** @return Number of bytes waiting to be written into the wrapped stream. */
+COMM_PUBLIC size_t COMM_CALL comm_packet_stream_pending(const comm_packet_stream_t* packetStream);
+
 COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* packetStream, uint8_t* lenOut);
 
 #ifdef __cplusplus
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "line_stream.h"
+#include "packet_stream.h"
+
+/** Uses io_uring when available, falling back to epoll otherwise. */
+#define COMM_REACTOR_BACKEND_AUTO     0
+
+/** Edge-triggered epoll. */
+#define COMM_REACTOR_BACKEND_EPOLL    1
+
+/**
+ * io_uring: reads stay posted for every registered stream (into buffers shared by all streams),
+ * and writes to registered streams are queued and submitted in one batch per
+ * comm_reactor_run_once() call, together with the wait for completions.
+ */
+#define COMM_REACTOR_BACKEND_IO_URING 2
+
+typedef comm_obj_t            comm_reactor_t;
+typedef comm_obj_controller_t comm_reactor_controller_t;
+
+/** Called for every complete line read from a registered line stream. */
+typedef void (COMM_CALL *comm_reactor_on_line_t)(comm_line_stream_t* lineStream, char* line, void* userData);
+
+/** Called for every complete packet read from a registered packet stream. */
+typedef void (COMM_CALL *comm_reactor_on_packet_t)(comm_packet_stream_t* packetStream, uint8_t* packet, uint8_t len, void* userData);
+
+/**
+ * Called once a registered stream hangs up or fails. The stream is already unregistered when
+ * this is called, so it may be deleted from the callback.
+ */
+typedef void (COMM_CALL *comm_reactor_on_close_t)(comm_stream_t* stream, void* userData);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a reactor dispatching frames from many fd-backed line/packet streams on a single
+ * thread. Registered streams must be non-blocking (created with blockRead = false) and must wrap
+ * (directly or through other wrappers) a comm_fd_stream. Available on Linux only (elsewhere,
+ * creation fails with errno set to COMM_ERROR_INVPARAM).
+ *
+ * With the io_uring backend, the reactor performs all I/O of registered streams: data written to
+ * them is sent by the next comm_reactor_run_once() call, and up to 256 KiB per stream may be
+ * queued (further writes are refused, so non-blocking writes should be used for flow control).
+ * Once a stream is removed, data still queued is read (or written) before its descriptor.
+ *
+ * @param backend One of COMM_REACTOR_BACKEND_* values. Creation fails (with errno set to
+ *                COMM_ERROR_IO) if an explicitly requested backend is not available.
+ */
+COMM_PUBLIC comm_reactor_t* COMM_CALL comm_reactor_new(uint32_t backend, const comm_reactor_controller_t* controller, void* data);
+
+/** @return Backend in use (either COMM_REACTOR_BACKEND_EPOLL or COMM_REACTOR_BACKEND_IO_URING). */
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_backend(const comm_reactor_t* reactor);
+
+/** Registers a line stream. Callbacks are invoked from comm_reactor_run_once(). */
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_line_stream(comm_reactor_t* reactor, comm_line_stream_t* lineStream, comm_reactor_on_line_t onLine, comm_reactor_on_close_t onClose, void* userData);
+
+/** Registers a packet stream. Callbacks are invoked from comm_reactor_run_once(). */
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_packet_stream(comm_reactor_t* reactor, comm_packet_stream_t* packetStream, comm_reactor_on_packet_t onPacket, comm_reactor_on_close_t onClose, void* userData);
+
+/** Unregisters a stream. It is safe to call this function from reactor callbacks. */
+COMM_PUBLIC bool COMM_CALL comm_reactor_remove(comm_reactor_t* reactor, comm_stream_t* stream);
+
+/** @return Number of registered streams. */
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_count(const comm_reactor_t* reactor);
+
+/**
+ * Waits for readiness of registered streams and dispatches their complete frames. Pending output
+ * of streams using non-blocking writes is resumed (flushed) once they become writable.
+ *
+ * @param timeoutMs Maximum wait time (COMM_STREAM_WAIT_FOREVER waits indefinitely).
+ * @return Number of dispatched frames, or -1 on error.
+ */
+COMM_PUBLIC int32_t COMM_CALL comm_reactor_run_once(comm_reactor_t* reactor, uint32_t timeoutMs);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
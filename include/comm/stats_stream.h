@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+/**
+ * Number of request size histogram buckets. Bucket 0 counts zero-length requests, and bucket n
+ * (n > 0) counts requests of [2^(n-1), 2^n) bytes.
+ */
+#define COMM_STATS_STREAM_BUCKETS 33
+
+typedef comm_stream_t         comm_stats_stream_t;
+typedef comm_obj_controller_t comm_stats_stream_controller_t;
+
+typedef struct comm_stats_stream_dir      comm_stats_stream_dir_t;
+typedef struct comm_stats_stream_snapshot comm_stats_stream_snapshot_t;
+
+/** Statistics of one transfer direction (vectored calls count as a single request). */
+struct comm_stats_stream_dir {
+	uint64_t calls;
+	uint64_t bytes;        // Bytes actually transferred
+	uint64_t zeroReturns;  // Non-empty requests transferring nothing
+	uint64_t shortReturns; // Requests partially served
+	uint64_t errors;
+	uint64_t sizes[COMM_STATS_STREAM_BUCKETS]; // Histogram of requested sizes
+};
+
+struct comm_stats_stream_snapshot {
+	comm_stats_stream_dir_t read;
+	comm_stats_stream_dir_t write;
+	uint64_t flushes;
+	uint64_t flushErrors;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a pass-through stream wrapper recording statistics about the operations on 'wrapped'.
+ *
+ * Counters are updated without locking: each direction is expected to be used by a single thread
+ * at a time (as any stream), while snapshots may be taken from any thread.
+ */
+COMM_PUBLIC comm_stats_stream_t* COMM_CALL comm_stats_stream_new(comm_stream_t* wrapped, const comm_stats_stream_controller_t* controller, void* data);
+
+/** Copies current statistics into 'snapshot'. */
+COMM_PUBLIC void COMM_CALL comm_stats_stream_snapshot(const comm_stats_stream_t* stream, comm_stats_stream_snapshot_t* snapshot);
+
+/** Resets all statistics (must not race with stream operations). */
+COMM_PUBLIC void COMM_CALL comm_stats_stream_reset(comm_stats_stream_t* stream);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -23,8 +23,16 @@ SOFTWARE.
 
 #include "obj.h"
 
+#define COMM_STREAM_WAIT_FOREVER UINT32_MAX
+
 typedef comm_obj_t                    comm_stream_t;
 typedef struct comm_stream_controller comm_stream_controller_t;
+typedef struct comm_stream_vec        comm_stream_vec_t;
+
+struct comm_stream_vec {
+	void*    data;
+	uint32_t len;
+};
 
 struct comm_stream_controller {
 	comm_obj_controller_t objController;
@@ -37,6 +45,14 @@ struct comm_stream_controller {
 	bool (COMM_CALL *flush)(comm_stream_t* stream);
 
 	bool (COMM_CALL *close)(comm_stream_t* stream);
+
+	// Optional scatter/gather operations (a generic implementation based on read/write is used when absent)
+	int32_t (COMM_CALL *readv)(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+	int32_t (COMM_CALL *writev)(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+
+	// Optional readiness waits (when absent, callers keep polling the stream)
+	bool (COMM_CALL *wait_readable)(comm_stream_t* stream, uint32_t timeoutMs);
+	bool (COMM_CALL *wait_writable)(comm_stream_t* stream, uint32_t timeoutMs);
 };
 
 #ifdef __cplusplus
@@ -53,10 +69,56 @@ COMM_PUBLIC uint32_t COMM_CALL comm_stream_available_write(const comm_stream_t*
 
 COMM_PUBLIC int32_t COMM_CALL comm_stream_write(comm_stream_t* stream, const void* in, uint32_t len);
 
+/**
+ * Reads into multiple regions with a single call.
+ *
+ * @return Total number of bytes read (regions are filled in order, and a region is only used
+ *         after the previous one was completely filled), or -1 on error.
+ */
+COMM_PUBLIC int32_t COMM_CALL comm_stream_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+
+/**
+ * Writes multiple regions with a single call.
+ *
+ * @return Total number of bytes written (regions are consumed in order), or -1 on error.
+ */
+COMM_PUBLIC int32_t COMM_CALL comm_stream_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+
+/**
+ * Blocks until the stream has data to be read or until timeout expires.
+ *
+ * @param timeoutMs Timeout in milliseconds (COMM_STREAM_WAIT_FOREVER disables the timeout).
+ *
+ * @return false if timeout expired, otherwise true. Streams not supporting waits return true
+ *         immediately.
+ */
+COMM_PUBLIC bool COMM_CALL comm_stream_wait_readable(comm_stream_t* stream, uint32_t timeoutMs);
+
+/**
+ * Blocks until the stream accepts data to be written or until timeout expires.
+ *
+ * @see comm_stream_wait_readable()
+ */
+COMM_PUBLIC bool COMM_CALL comm_stream_wait_writable(comm_stream_t* stream, uint32_t timeoutMs);
+
 COMM_PUBLIC bool COMM_CALL comm_stream_flush(comm_stream_t* stream);
 
 COMM_PUBLIC bool COMM_CALL comm_stream_close(comm_stream_t* stream);
 
+/**
+ * Moves data from 'src' into 'dst' while 'src' reports available data, up to 'maxBytes'.
+ *
+ * Payload is relayed inside the kernel (copy_file_range, sendfile or splice) when both streams
+ * are fd streams, and read/written in place when one of them is a comm_buffer. Other streams are
+ * copied through an intermediate buffer. Blocking destinations (fd streams and SPSC buffers, or
+ * streams wrapping them) are waited for, while copying into other destinations stops once they
+ * are full.
+ *
+ * @return Number of moved bytes (with errno set to COMM_ERROR_AGAIN if copying stopped because
+ *         'dst' is full), or -1 on error (if nothing was moved).
+ */
+COMM_PUBLIC int64_t COMM_CALL comm_stream_copy(comm_stream_t* src, comm_stream_t* dst, uint64_t maxBytes);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "stream.h"
+
+/** Data a sink does not accept right away is dropped for that sink. */
+#define COMM_TEE_STREAM_DROP   0
+
+/** Waits for the sink to accept data (a slow sink stalls the tee). */
+#define COMM_TEE_STREAM_BLOCK  1
+
+/** Data a sink does not accept right away is kept in a per-sink backlog. */
+#define COMM_TEE_STREAM_BUFFER 2
+
+typedef comm_stream_t         comm_tee_stream_t;
+typedef comm_obj_controller_t comm_tee_stream_controller_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a write-only stream delivering every write to a set of sink streams.
+ *
+ * Each write (or vectored write) is delivered to a sink either entirely or not at all, so that
+ * framed data (e.g. a packet stream stacked on the tee) is never cut on dropping sinks. Sinks are
+ * not owned by the tee.
+ *
+ * Writes always report every byte as written. A sink failing to write stops receiving data and
+ * what it missed is counted as dropped; a failing COMM_TEE_STREAM_BLOCK sink also sets errno to
+ * COMM_ERROR_IO.
+ */
+COMM_PUBLIC comm_tee_stream_t* COMM_CALL comm_tee_stream_new(const comm_tee_stream_controller_t* controller, void* data);
+
+/**
+ * Adds a sink.
+ *
+ * @param policy One of COMM_TEE_STREAM_* values.
+ * @param maxBacklog Maximum backlog size for COMM_TEE_STREAM_BUFFER sinks (zero means no limit).
+ *                   Writes not fitting in the backlog are dropped.
+ */
+COMM_PUBLIC bool COMM_CALL comm_tee_stream_add_sink(comm_tee_stream_t* tee, comm_stream_t* sink, uint32_t policy, size_t maxBacklog);
+
+/** Removes a sink. Its backlog is discarded. */
+COMM_PUBLIC bool COMM_CALL comm_tee_stream_remove_sink(comm_tee_stream_t* tee, comm_stream_t* sink);
+
+/** @return Number of bytes dropped for given sink (including data for sinks that failed). */
+COMM_PUBLIC uint64_t COMM_CALL comm_tee_stream_dropped(const comm_tee_stream_t* tee, const comm_stream_t* sink);
+
+/** @return Number of bytes waiting in the backlog of given sink. */
+COMM_PUBLIC size_t COMM_CALL comm_tee_stream_backlog(const comm_tee_stream_t* tee, const comm_stream_t* sink);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
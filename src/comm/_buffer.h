@@ -32,8 +32,25 @@ struct _comm_buffer {
 	const comm_buffer_controller_t* controller;
 	uint8_t* storage;
 	size_t   capacity;
+	size_t   mask; // capacity - 1 for power-of-two capacities (cursors are free-running counters), otherwise zero
 	size_t   readCursor;
 	size_t   writeCursor;
 	bool     lastRead;
 	bool     wrapped;
+	bool     mirrored;
 };
+
+// Controller shared by all buffers (also used as their type tag)
+extern const comm_stream_controller_t _comm_buffer_controller;
+
+uint32_t COMM_CALL _comm_buffer_available_read(const comm_stream_t* stream);
+int32_t  COMM_CALL _comm_buffer_read(comm_stream_t* stream, void* out, uint32_t len);
+uint32_t COMM_CALL _comm_buffer_available_write(const comm_stream_t* stream);
+int32_t  COMM_CALL _comm_buffer_write(comm_stream_t* stream, const void* in, uint32_t len);
+int32_t  COMM_CALL _comm_buffer_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+int32_t  COMM_CALL _comm_buffer_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+
+/** @return Whether given stream is a comm_buffer. */
+static inline bool _comm_buffer_is(const comm_stream_t* stream) {
+	return stream->controller == &_comm_buffer_controller.objController;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <comm/fd_stream.h>
+#include <comm/chain_buffer.h>
+
+/** Called when the output queue of an attached stream stops being empty. */
+typedef void (*_comm_fd_stream_on_output_t)(void* context);
+
+/**
+ * Switches an fd stream to queued I/O, in which a reactor performs the system calls: reads are
+ * served from bytes handed over with _comm_fd_stream_receive(), and writes are queued (up to
+ * 'maxOutput' bytes) into _comm_fd_stream_output() for the reactor to submit. 'onOutput' is
+ * called (from the writing thread) whenever a write makes the output queue non-empty.
+ */
+bool _comm_fd_stream_attach(comm_fd_stream_t* stream, size_t maxOutput, _comm_fd_stream_on_output_t onOutput, void* context);
+
+/** Switches back to direct I/O. Bytes still queued are read (or written) before the descriptor. */
+void _comm_fd_stream_detach(comm_fd_stream_t* stream);
+
+bool _comm_fd_stream_is_socket(const comm_fd_stream_t* stream);
+
+/** Appends bytes received by the reactor. */
+bool _comm_fd_stream_receive(comm_fd_stream_t* stream, const void* data, uint32_t len);
+
+/** @return Bytes written but not submitted yet (consumed as they are submitted). */
+comm_chain_buffer_t* _comm_fd_stream_output(comm_fd_stream_t* stream);
+
+/** @return Whether the stream has no queued I/O, so that its descriptor may be used directly. */
+bool _comm_fd_stream_is_direct(const comm_fd_stream_t* stream);
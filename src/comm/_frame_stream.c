@@ -0,0 +1,266 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_frame_stream.h"
+#include "_stream_dispatch.h"
+#include "_error.h"
+
+#define __PENDING_CHUNK_SIZE 4096
+#define __PEEK_REGIONS       8
+
+#define __TARGET(stream) (((_comm_stream_wrapper_t*)(stream))->writeTarget)
+
+// Writes pending output into the wrapped stream straight from pending buffer chunks. When 'block'
+// is false, stops as soon as the wrapped stream does not accept more data.
+static bool __drain(_comm_frame_stream_t* stream, bool block) {
+	comm_stream_vec_t vec[__PEEK_REGIONS];
+	uint32_t count;
+
+	while (stream->pending && (count = comm_chain_buffer_peek(stream->pending, vec, __PEEK_REGIONS)) > 0) {
+		int32_t written = _comm_stream_dispatch_writev(__TARGET(stream), vec, count);
+
+		if (written < 0)
+			return false;
+
+		if (written == 0) {
+			if (!block)
+				break;
+
+			if (!comm_stream_wait_writable(__TARGET(stream), COMM_STREAM_WAIT_FOREVER))
+				return false;
+
+			continue;
+		}
+
+		_comm_stream_dispatch_read(stream->pending, NULL, (uint32_t)written);
+	}
+
+	return true;
+}
+
+// Makes sure 'len' bytes can be queued without failing
+static bool __reserve(_comm_frame_stream_t* stream, size_t len) {
+	if (!stream->pending) {
+		stream->pending = comm_chain_buffer_new(__PENDING_CHUNK_SIZE, 0, NULL, NULL);
+
+		if (!stream->pending)
+			return false;
+	}
+
+	return comm_chain_buffer_reserve(stream->pending, len);
+}
+
+static bool __queue(_comm_frame_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	if (!stream->pending) {
+		stream->pending = comm_chain_buffer_new(__PENDING_CHUNK_SIZE, 0, NULL, NULL);
+
+		if (!stream->pending)
+			return false;
+	}
+
+	// Frames are queued whole: a failure leaves pending output as it was
+	size_t prior = comm_chain_buffer_size(stream->pending);
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (_comm_stream_dispatch_write(stream->pending, vec[i].data, vec[i].len) != (int32_t)vec[i].len) {
+			comm_chain_buffer_truncate(stream->pending, prior);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Writes all regions (in place updating them on partial writes), waiting for the wrapped stream.
+static bool __write_all(comm_stream_t* target, comm_stream_vec_t* vec, uint32_t count) {
+	while (count) {
+		int32_t written = _comm_stream_dispatch_writev(target, vec, count);
+
+		if (written < 0)
+			return false;
+
+		if (written == 0 && !comm_stream_wait_writable(target, COMM_STREAM_WAIT_FOREVER))
+			return false;
+
+		while (count && (uint32_t)written >= vec->len) {
+			written -= vec->len;
+			vec++;
+			count--;
+		}
+
+		if (count) {
+			vec->data = (uint8_t*)vec->data + written;
+			vec->len -= written;
+		}
+	}
+
+	return true;
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+	return _comm_frame_stream_pending((const _comm_frame_stream_t*)stream) ? 0 : _comm_stream_dispatch_available_write(__TARGET(stream));
+}
+
+// Plain writes never wait: they are refused while there is pending output
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	if (!__drain((_comm_frame_stream_t*)stream, false))
+		return -1;
+
+	return _comm_frame_stream_pending((_comm_frame_stream_t*)stream) ? 0 : _comm_stream_dispatch_write(__TARGET(stream), in, len);
+}
+
+static int32_t COMM_CALL __writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	if (!__drain((_comm_frame_stream_t*)stream, false))
+		return -1;
+
+	return _comm_frame_stream_pending((_comm_frame_stream_t*)stream) ? 0 : _comm_stream_dispatch_writev(__TARGET(stream), vec, count);
+}
+
+static bool COMM_CALL __flush(comm_stream_t* xStream) {
+	_comm_frame_stream_t* stream = (_comm_frame_stream_t*)xStream;
+
+	return __drain(stream, stream->blockWrite) && _comm_stream_dispatch_flush(__TARGET(stream));
+}
+
+static bool COMM_CALL __close(comm_stream_t* stream) {
+	return __flush(stream);
+}
+
+// Read operations are passed through (so that outer wrappers may bypass frame streams when reading)
+static const comm_stream_controller_t __streamController = {
+	.objController.on_deinit = _comm_stream_wrapper_on_deinit,
+
+	.available_read  = _comm_stream_wrapper_available_read,
+	.read            = _comm_stream_wrapper_read,
+	.available_write = __available_write,
+	.write           = __write,
+	.flush           = __flush,
+	.close           = __close,
+	.readv           = _comm_stream_wrapper_readv,
+	.writev          = __writev,
+	.wait_readable   = _comm_stream_wrapper_wait_readable,
+	.wait_writable   = _comm_stream_wrapper_wait_writable
+};
+
+bool _comm_frame_stream_is(const comm_stream_t* stream) {
+	return stream->controller == &__streamController.objController;
+}
+
+void _comm_frame_stream_init(_comm_frame_stream_t* stream, comm_stream_t* wrapped, bool blockRead, const _comm_stream_wrapper_controller_t* controller, void* data) {
+	stream->pending = NULL;
+	stream->maxPending = 0;
+	stream->blockRead = blockRead;
+	stream->blockWrite = true;
+
+	_comm_stream_wrapper_init_with((_comm_stream_wrapper_t*)stream, wrapped, &__streamController, controller, data);
+}
+
+void _comm_frame_stream_deinit(_comm_frame_stream_t* stream) {
+	if (stream->pending)
+		comm_obj_del(stream->pending);
+}
+
+void _comm_frame_stream_set_block_write(_comm_frame_stream_t* stream, bool blockWrite, size_t maxPending) {
+	stream->blockWrite = blockWrite;
+	stream->maxPending = maxPending;
+}
+
+size_t _comm_frame_stream_pending(const _comm_frame_stream_t* stream) {
+	return stream->pending ? comm_chain_buffer_size(stream->pending) : 0;
+}
+
+bool _comm_frame_stream_fits(_comm_frame_stream_t* stream, size_t len) {
+	if (stream->blockWrite || !stream->maxPending)
+		return true;
+
+	if (!__drain(stream, false)) {
+		_COMM_ERROR_SET(COMM_ERROR_IO);
+		return false;
+	}
+
+	if (_comm_frame_stream_pending(stream) + len > stream->maxPending) {
+		errno = COMM_ERROR_AGAIN;
+		return false;
+	}
+
+	return true;
+}
+
+bool _comm_frame_stream_write(_comm_frame_stream_t* stream, comm_stream_vec_t* vec, uint32_t count) {
+	size_t total = 0;
+
+	if (stream->blockWrite) {
+		if (!__drain(stream, true) || !__write_all(__TARGET(stream), vec, count))
+			goto error;
+
+		return true;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+		total += vec[i].len;
+
+	if (!_comm_frame_stream_fits(stream, total))
+		return false;
+
+	if (!__drain(stream, false))
+		goto error;
+
+	// Frame is queued behind pending output
+	if (_comm_frame_stream_pending(stream)) {
+		if (!__queue(stream, vec, count))
+			goto error;
+
+		return true;
+	}
+
+	// Room for the whole frame is reserved first: once part of it is written, queueing the
+	// remainder must not fail, otherwise the peer would get a truncated frame
+	if (!__reserve(stream, total))
+		return false;
+
+	int32_t written = _comm_stream_dispatch_writev(__TARGET(stream), vec, count);
+
+	if (written < 0)
+		goto error;
+
+	// Remainder is queued
+	while (count && (uint32_t)written >= vec->len) {
+		written -= vec->len;
+		vec++;
+		count--;
+	}
+
+	if (count) {
+		vec->data = (uint8_t*)vec->data + written;
+		vec->len -= written;
+
+		if (!__queue(stream, vec, count))
+			goto error;
+	} else {
+		comm_chain_buffer_clear(stream->pending); // Releases the unused reservation
+	}
+
+	return true;
+
+error:
+	_COMM_ERROR_SET(COMM_ERROR_IO);
+	return false;
+}
@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "_stream_wrapper.h"
+#include <comm/chain_buffer.h>
+
+// Base of line and packet streams. Frames are written either waiting for the wrapped stream
+// (default), or, with non-blocking writes, queueing the part of a frame not accepted by the wrapped
+// stream into a pending buffer. Pending output is written before any later output, and is resumed
+// by later writes and by flushes.
+
+typedef struct _comm_frame_stream _comm_frame_stream_t;
+
+struct _comm_frame_stream {
+	_comm_stream_wrapper_t wrapper;
+
+	comm_chain_buffer_t* pending; // Allocated on demand
+	size_t maxPending;
+	bool   blockRead;  // Reads wait for a whole frame (set on creation)
+	bool   blockWrite;
+};
+
+/** @return true if given stream is a frame stream (i.e. a line or packet stream). */
+bool _comm_frame_stream_is(const comm_stream_t* stream);
+
+void _comm_frame_stream_init(_comm_frame_stream_t* stream, comm_stream_t* wrapped, bool blockRead, const _comm_stream_wrapper_controller_t* controller, void* data);
+
+/** Releases pending output (to be called by the deinitializer of derived streams). */
+void _comm_frame_stream_deinit(_comm_frame_stream_t* stream);
+
+void _comm_frame_stream_set_block_write(_comm_frame_stream_t* stream, bool blockWrite, size_t maxPending);
+
+/** @return Number of bytes waiting to be written into the wrapped stream. */
+size_t _comm_frame_stream_pending(const _comm_frame_stream_t* stream);
+
+/**
+ * Checks whether a frame of 'len' bytes would be accepted by _comm_frame_stream_write() (always
+ * true with blocking writes). Fails with errno set to COMM_ERROR_AGAIN otherwise.
+ */
+bool _comm_frame_stream_fits(_comm_frame_stream_t* stream, size_t len);
+
+/**
+ * Writes a frame made of given regions (which are updated in place). With non-blocking writes, the
+ * frame is either written or queued as a whole: if it does not fit into the pending buffer, nothing
+ * is written and errno is set to COMM_ERROR_AGAIN. The stream is not flushed.
+ */
+bool _comm_frame_stream_write(_comm_frame_stream_t* stream, comm_stream_vec_t* vec, uint32_t count);
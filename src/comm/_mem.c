@@ -20,6 +20,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "_mem.h"
+#include "_slab.h"
+#include "_trace.h"
+
+#include <comm/mem.h>
 
 #if defined __has_include
 	#if __has_include (<comm_config.h>)
@@ -39,9 +43,13 @@ SOFTWARE.
 	#define _COMM_MEM_FREE_FN free
 #endif
 
+#ifndef _COMM_MEM_SLAB
+	#define _COMM_MEM_SLAB 0
+#endif
+
 #include _COMM_MEM_HEADER
 
-COMM_PUBLIC void* COMM_CALL _comm_mem_alloc(size_t size) {
+void* _comm_mem_raw_alloc(size_t size) {
 	void* ptr = _COMM_MEM_ALLOC_FN(size);
 	if (!ptr)
 		errno = COMM_ERROR_NOMEM;
@@ -49,6 +57,36 @@ COMM_PUBLIC void* COMM_CALL _comm_mem_alloc(size_t size) {
 	return ptr;
 }
 
-COMM_PUBLIC void COMM_CALL _comm_mem_free(void* ptr) {
+void _comm_mem_raw_free(void* ptr) {
 	_COMM_MEM_FREE_FN(ptr);
 }
+
+#if _COMM_MEM_SLAB
+COMM_PUBLIC void* COMM_CALL _comm_mem_alloc(size_t size) {
+	void* ptr = _comm_slab_alloc(size);
+
+	_COMM_TRACE2(mem_alloc, size, ptr);
+	return ptr;
+}
+
+COMM_PUBLIC void COMM_CALL _comm_mem_free(void* ptr) {
+	_comm_slab_free(ptr);
+}
+
+COMM_PUBLIC void COMM_CALL comm_mem_trim() {
+	_comm_slab_trim();
+}
+#else
+COMM_PUBLIC void* COMM_CALL _comm_mem_alloc(size_t size) {
+	void* ptr = _comm_mem_raw_alloc(size);
+
+	_COMM_TRACE2(mem_alloc, size, ptr);
+	return ptr;
+}
+
+COMM_PUBLIC void COMM_CALL _comm_mem_free(void* ptr) {
+	_comm_mem_raw_free(ptr);
+}
+
+COMM_PUBLIC void COMM_CALL comm_mem_trim() {}
+#endif
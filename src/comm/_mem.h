@@ -31,6 +31,11 @@ void* _comm_mem_alloc(size_t size);
 
 void _comm_mem_free(void* ptr);
 
+// Allocation functions bypassing the slab allocator (see _slab.h)
+void* _comm_mem_raw_alloc(size_t size);
+
+void _comm_mem_raw_free(void* ptr);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
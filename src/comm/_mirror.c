@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "_mirror.h"
+
+#if defined __has_include
+	#if __has_include (<comm_config.h>)
+		#include <comm_config.h>
+	#endif
+#endif
+
+#ifndef _COMM_BUFFER_MIRROR
+	#ifdef __linux__
+		#define _COMM_BUFFER_MIRROR 1
+	#else
+		#define _COMM_BUFFER_MIRROR 0
+	#endif
+#endif
+
+#if _COMM_BUFFER_MIRROR
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+uint8_t* _comm_mirror_alloc(size_t capacity) {
+	long pageSize = sysconf(_SC_PAGESIZE);
+
+	if (capacity == 0 || pageSize <= 0 || capacity % (size_t)pageSize)
+		return NULL;
+
+	// Failures fall back to heap storage, so they must not leak into errno
+	int mErrno = errno;
+	uint8_t* storage = NULL;
+	int fd = memfd_create("comm_buffer", MFD_CLOEXEC);
+
+	if (fd < 0)
+		goto error;
+
+	if (ftruncate(fd, capacity) != 0)
+		goto error;
+
+	storage = mmap(NULL, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (storage == MAP_FAILED) {
+		storage = NULL;
+		goto error;
+	}
+
+	if (mmap(storage, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+		goto error;
+
+	if (mmap(storage + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+		goto error;
+
+	close(fd);
+	return storage;
+
+error:
+	if (storage)
+		munmap(storage, 2 * capacity);
+
+	if (fd >= 0)
+		close(fd);
+
+	errno = mErrno;
+	return NULL;
+}
+
+void _comm_mirror_free(uint8_t* storage, size_t capacity) {
+	munmap(storage, 2 * capacity);
+}
+#else
+uint8_t* _comm_mirror_alloc(size_t capacity) {
+	(void)capacity;
+	return NULL;
+}
+
+void _comm_mirror_free(uint8_t* storage, size_t capacity) {
+	(void)storage;
+	(void)capacity;
+}
+#endif
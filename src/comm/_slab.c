@@ -0,0 +1,210 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_slab.h"
+#include "_mem.h"
+
+#define __MIN_BLOCK_SIZE  32
+#define __CLASS_COUNT     8     // 32, 64, ..., 4096
+#define __SLAB_SIZE       16384 // Approximate size of a slab
+#define __MIN_SLAB_BLOCKS 4
+
+typedef struct __slab   __slab_t;
+typedef struct __header __header_t;
+typedef struct __block  __block_t;
+typedef struct __class  __class_t;
+
+struct __slab {
+	__slab_t* next;
+	size_t    cls;
+	size_t    inUse;
+};
+
+// Precedes every block handed out (slab is NULL for blocks forwarded to the raw allocator).
+// Its size keeps returned pointers aligned as malloc() would.
+struct __header {
+	__slab_t* slab;
+	size_t    padding;
+};
+
+// Free blocks are linked through their own payload
+struct __block {
+	__block_t* next;
+};
+
+struct __class {
+	bool       lock;
+	__block_t* freeList;
+	__slab_t*  slabs;
+};
+
+// Slab header rounded up to a multiple of block header size (keeps blocks aligned)
+#define __SLAB_HEADER_SIZE (((sizeof(__slab_t) + sizeof(__header_t) - 1) / sizeof(__header_t)) * sizeof(__header_t))
+
+static __class_t __classes[__CLASS_COUNT];
+
+static void __lock(__class_t* cls) {
+	while (__atomic_test_and_set(&cls->lock, __ATOMIC_ACQUIRE));
+}
+
+static void __unlock(__class_t* cls) {
+	__atomic_clear(&cls->lock, __ATOMIC_RELEASE);
+}
+
+static size_t __block_size(size_t cls) {
+	return (size_t)__MIN_BLOCK_SIZE << cls;
+}
+
+static size_t __class_of(size_t size) {
+	size_t cls = 0;
+
+	while (__block_size(cls) < size)
+		cls++;
+
+	return cls;
+}
+
+static __header_t* __header_of(const __block_t* block) {
+	return (__header_t*)block - 1;
+}
+
+static size_t __slab_blocks(size_t cls) {
+	size_t blocks = __SLAB_SIZE / (sizeof(__header_t) + __block_size(cls));
+	return blocks < __MIN_SLAB_BLOCKS ? __MIN_SLAB_BLOCKS : blocks;
+}
+
+static bool __grow(__class_t* mClass, size_t cls) {
+	size_t stride = sizeof(__header_t) + __block_size(cls);
+	size_t blocks = __slab_blocks(cls);
+	__slab_t* slab = _comm_mem_raw_alloc(__SLAB_HEADER_SIZE + blocks * stride);
+
+	if (!slab)
+		return false;
+
+	slab->cls = cls;
+	slab->inUse = 0;
+	slab->next = mClass->slabs;
+	mClass->slabs = slab;
+
+	uint8_t* cursor = (uint8_t*)slab + __SLAB_HEADER_SIZE;
+
+	for (size_t i = 0; i < blocks; i++) {
+		__header_t* header = (__header_t*)cursor;
+		__block_t* block = (__block_t*)(header + 1);
+
+		header->slab = slab;
+		block->next = mClass->freeList;
+		mClass->freeList = block;
+
+		cursor += stride;
+	}
+
+	return true;
+}
+
+void* _comm_slab_alloc(size_t size) {
+	__header_t* header;
+
+	if (size > _COMM_SLAB_MAX_BLOCK_SIZE) {
+		header = _comm_mem_raw_alloc(sizeof(__header_t) + size);
+
+		if (!header)
+			return NULL;
+
+		header->slab = NULL;
+		return header + 1;
+	}
+
+	size_t cls = __class_of(size);
+	__class_t* mClass = &__classes[cls];
+	__block_t* block = NULL;
+
+	__lock(mClass);
+
+	if (mClass->freeList || __grow(mClass, cls)) {
+		block = mClass->freeList;
+		mClass->freeList = block->next;
+		__header_of(block)->slab->inUse++;
+	}
+
+	__unlock(mClass);
+
+	return block;
+}
+
+void _comm_slab_free(void* ptr) {
+	if (!ptr)
+		return;
+
+	__block_t* block = ptr;
+	__header_t* header = __header_of(block);
+	__slab_t* slab = header->slab;
+
+	if (!slab) {
+		_comm_mem_raw_free(header);
+		return;
+	}
+
+	__class_t* mClass = &__classes[slab->cls];
+
+	__lock(mClass);
+
+	block->next = mClass->freeList;
+	mClass->freeList = block;
+	slab->inUse--;
+
+	__unlock(mClass);
+}
+
+void _comm_slab_trim() {
+	for (size_t cls = 0; cls < __CLASS_COUNT; cls++) {
+		__class_t* mClass = &__classes[cls];
+
+		__lock(mClass);
+
+		// Unlink free blocks belonging to unused slabs...
+		__block_t** link = &mClass->freeList;
+
+		while (*link) {
+			if (__header_of(*link)->slab->inUse == 0) {
+				*link = (*link)->next;
+			} else {
+				link = &(*link)->next;
+			}
+		}
+
+		// ...then release these slabs
+		__slab_t** slabLink = &mClass->slabs;
+
+		while (*slabLink) {
+			__slab_t* slab = *slabLink;
+
+			if (slab->inUse == 0) {
+				*slabLink = slab->next;
+				_comm_mem_raw_free(slab);
+			} else {
+				slabLink = &slab->next;
+			}
+		}
+
+		__unlock(mClass);
+	}
+}
@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <comm/defs.h>
+
+// Size-class slab allocator. Blocks of up to _COMM_SLAB_MAX_BLOCK_SIZE bytes are carved from
+// slabs obtained through _comm_mem_raw_alloc() and recycled through per-class free lists.
+// Larger blocks are forwarded to _comm_mem_raw_alloc().
+//
+// _comm_mem_alloc()/_comm_mem_free() route to this allocator when _COMM_MEM_SLAB is defined
+// to a non-zero value in comm_config.h.
+
+#define _COMM_SLAB_MAX_BLOCK_SIZE 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* _comm_slab_alloc(size_t size);
+
+void _comm_slab_free(void* ptr);
+
+/** Returns slabs without any block in use to the underlying allocator (see comm_mem_trim()). */
+void _comm_slab_trim();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
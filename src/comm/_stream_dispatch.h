@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include "_stream.h"
+#include "_buffer.h"
+#include "_error.h"
+
+// Header-inline stream dispatch used by comm_stream_*() and by internal wrappers on their hot
+// paths. comm_buffer operations (recognized by their controller) are direct calls, which the
+// compiler can inline across translation units in LTO builds. Other streams are dispatched
+// through their controller.
+//
+// Tracepoints are emitted by the public comm_stream_*() entry points only, so that a call going
+// through several wrappers is traced once.
+
+static inline uint32_t _comm_stream_dispatch_available_read(const comm_stream_t* stream) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+
+	if (_comm_buffer_is(stream))
+		return _comm_buffer_available_read(stream);
+
+	return controller && controller->available_read ? controller->available_read(stream) : 0;
+}
+
+static inline int32_t _comm_stream_dispatch_read(comm_stream_t* stream, void* out, uint32_t len) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+	int32_t read = 0;
+
+	if (_comm_buffer_is(stream)) {
+		read = _comm_buffer_read(stream, out, len); // Never fails
+	} else if (controller && controller->read) {
+		read = controller->read(stream, out, len);
+		if (read < 0) {
+			_COMM_ERROR_SET(COMM_ERROR_IO);
+		}
+	}
+
+	return read;
+}
+
+static inline uint32_t _comm_stream_dispatch_available_write(const comm_stream_t* stream) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+
+	if (_comm_buffer_is(stream))
+		return _comm_buffer_available_write(stream);
+
+	return controller && controller->available_write ? controller->available_write(stream) : 0;
+}
+
+static inline int32_t _comm_stream_dispatch_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+	int32_t written = 0;
+
+	if (_comm_buffer_is(stream)) {
+		written = _comm_buffer_write(stream, in, len); // Never fails
+	} else if (controller && controller->write) {
+		written = controller->write(stream, in, len);
+		if (written < 0) {
+			_COMM_ERROR_SET(COMM_ERROR_IO);
+		}
+	}
+
+	return written;
+}
+
+static inline int32_t _comm_stream_dispatch_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	return _comm_buffer_is(stream) ? _comm_buffer_readv(stream, vec, count) : comm_stream_readv(stream, vec, count);
+}
+
+static inline int32_t _comm_stream_dispatch_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	return _comm_buffer_is(stream) ? _comm_buffer_writev(stream, vec, count) : comm_stream_writev(stream, vec, count);
+}
+
+static inline bool _comm_stream_dispatch_flush(comm_stream_t* stream) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+	bool result = true;
+
+	// Buffers have nothing to flush
+	if (!_comm_buffer_is(stream) && controller && controller->flush) {
+		if (!controller->flush(stream)) {
+			_COMM_ERROR_SET(COMM_ERROR_IO);
+			result = false;
+		}
+	}
+
+	return result;
+}
@@ -20,57 +20,108 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "_stream_wrapper.h"
-#include "_stream.h"
+#include "_stream_dispatch.h"
 #include "_mem.h"
 #include "_error.h"
 
-static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+void COMM_CALL _comm_stream_wrapper_on_deinit(comm_obj_t* obj) {
 	_comm_stream_wrapper_t* wrapper = (_comm_stream_wrapper_t*)obj;
 	if (wrapper->controller && wrapper->controller->on_deinit) {
 		wrapper->controller->on_deinit(obj);
 	}
 }
 
-static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
-	return comm_stream_available_read(((_comm_stream_wrapper_t*)stream)->wrapped);
+uint32_t COMM_CALL _comm_stream_wrapper_available_read(const comm_stream_t* stream) {
+	return _comm_stream_dispatch_available_read(((_comm_stream_wrapper_t*)stream)->readTarget);
 }
 
-static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
-	return comm_stream_read(((_comm_stream_wrapper_t*)stream)->wrapped, out, len);
+int32_t COMM_CALL _comm_stream_wrapper_read(comm_stream_t* stream, void* out, uint32_t len) {
+	return _comm_stream_dispatch_read(((_comm_stream_wrapper_t*)stream)->readTarget, out, len);
 }
 
-static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
-	return comm_stream_available_write(((_comm_stream_wrapper_t*)stream)->wrapped);
+uint32_t COMM_CALL _comm_stream_wrapper_available_write(const comm_stream_t* stream) {
+	return _comm_stream_dispatch_available_write(((_comm_stream_wrapper_t*)stream)->writeTarget);
 }
 
-static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
-	return comm_stream_write(((_comm_stream_wrapper_t*)stream)->wrapped, in, len);
+int32_t COMM_CALL _comm_stream_wrapper_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	return _comm_stream_dispatch_write(((_comm_stream_wrapper_t*)stream)->writeTarget, in, len);
 }
 
-static bool COMM_CALL __flush(comm_stream_t* stream) {
-	return comm_stream_flush(((_comm_stream_wrapper_t*)stream)->wrapped);
+int32_t COMM_CALL _comm_stream_wrapper_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	return _comm_stream_dispatch_readv(((_comm_stream_wrapper_t*)stream)->readTarget, vec, count);
 }
 
-static bool COMM_CALL __close(comm_stream_t* stream) {
-	return comm_stream_flush(((_comm_stream_wrapper_t*)stream)->wrapped);
+int32_t COMM_CALL _comm_stream_wrapper_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	return _comm_stream_dispatch_writev(((_comm_stream_wrapper_t*)stream)->writeTarget, vec, count);
+}
+
+bool COMM_CALL _comm_stream_wrapper_wait_readable(comm_stream_t* stream, uint32_t timeoutMs) {
+	return comm_stream_wait_readable(((_comm_stream_wrapper_t*)stream)->readTarget, timeoutMs);
+}
+
+bool COMM_CALL _comm_stream_wrapper_wait_writable(comm_stream_t* stream, uint32_t timeoutMs) {
+	return comm_stream_wait_writable(((_comm_stream_wrapper_t*)stream)->writeTarget, timeoutMs);
+}
+
+bool COMM_CALL _comm_stream_wrapper_flush(comm_stream_t* stream) {
+	return _comm_stream_dispatch_flush(((_comm_stream_wrapper_t*)stream)->writeTarget);
+}
+
+bool COMM_CALL _comm_stream_wrapper_close(comm_stream_t* stream) {
+	return _comm_stream_dispatch_flush(((_comm_stream_wrapper_t*)stream)->wrapped);
 }
 
 static const comm_stream_controller_t __streamController = {
-	.objController.on_deinit = __on_deinit,
-
-	.available_read  = __available_read,
-	.read            = __read,
-	.available_write = __available_write,
-	.write           = __write,
-	.flush           = __flush,
-	.close           = __close
+	.objController.on_deinit = _comm_stream_wrapper_on_deinit,
+
+	.available_read  = _comm_stream_wrapper_available_read,
+	.read            = _comm_stream_wrapper_read,
+	.available_write = _comm_stream_wrapper_available_write,
+	.write           = _comm_stream_wrapper_write,
+	.flush           = _comm_stream_wrapper_flush,
+	.close           = _comm_stream_wrapper_close,
+	.readv           = _comm_stream_wrapper_readv,
+	.writev          = _comm_stream_wrapper_writev,
+	.wait_readable   = _comm_stream_wrapper_wait_readable,
+	.wait_writable   = _comm_stream_wrapper_wait_writable
 };
 
 void _comm_stream_wrapper_init(_comm_stream_wrapper_t* wrapper, comm_stream_t* wrapped, const _comm_stream_wrapper_controller_t* controller, void* data) {
-	wrapper->controller = controller;
-	wrapper->wrapped    = wrapped;
+	_comm_stream_wrapper_init_with(wrapper, wrapped, &__streamController, controller, data);
+}
+
+static bool __is_wrapper(const comm_stream_t* stream) {
+	return stream->controller && stream->controller->on_deinit == _comm_stream_wrapper_on_deinit;
+}
+
+static bool __passes_read(const comm_stream_t* stream) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
 
-	_comm_stream_init((comm_stream_t*)wrapper, &__streamController, data);
+	return __is_wrapper(stream)
+		&& controller->available_read == _comm_stream_wrapper_available_read
+		&& controller->read           == _comm_stream_wrapper_read
+		&& controller->readv          == _comm_stream_wrapper_readv
+		&& controller->wait_readable  == _comm_stream_wrapper_wait_readable;
+}
+
+static bool __passes_write(const comm_stream_t* stream) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+
+	return __is_wrapper(stream)
+		&& controller->available_write == _comm_stream_wrapper_available_write
+		&& controller->write           == _comm_stream_wrapper_write
+		&& controller->writev          == _comm_stream_wrapper_writev
+		&& controller->wait_writable   == _comm_stream_wrapper_wait_writable
+		&& controller->flush           == _comm_stream_wrapper_flush;
+}
+
+void _comm_stream_wrapper_init_with(_comm_stream_wrapper_t* wrapper, comm_stream_t* wrapped, const comm_stream_controller_t* streamController, const _comm_stream_wrapper_controller_t* controller, void* data) {
+	wrapper->controller  = controller;
+	wrapper->wrapped     = wrapped;
+	wrapper->readTarget  = __passes_read(wrapped)  ? ((_comm_stream_wrapper_t*)wrapped)->readTarget  : wrapped;
+	wrapper->writeTarget = __passes_write(wrapped) ? ((_comm_stream_wrapper_t*)wrapped)->writeTarget : wrapped;
+
+	_comm_stream_init((comm_stream_t*)wrapper, streamController, data);
 }
 
 _comm_stream_wrapper_t* _comm_stream_wrapper_new(comm_stream_t* wrapped, const _comm_stream_wrapper_controller_t* controller, void* data) {
@@ -94,3 +145,17 @@ error:
 
 	return NULL;
 }
+
+comm_stream_t* _comm_stream_wrapper_unwrap(comm_stream_t* stream) {
+	while (__is_wrapper(stream))
+		stream = ((_comm_stream_wrapper_t*)stream)->wrapped;
+
+	return stream;
+}
+
+bool _comm_stream_wrapper_can_wait_writable(const comm_stream_t* stream) {
+	while (__is_wrapper(stream))
+		stream = ((const _comm_stream_wrapper_t*)stream)->writeTarget;
+
+	return stream->controller && ((const comm_stream_controller_t*)stream->controller)->wait_writable;
+}
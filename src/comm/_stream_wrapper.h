@@ -32,8 +32,43 @@ struct _comm_stream_wrapper {
 
 	const _comm_stream_wrapper_controller_t* controller;
 	comm_stream_t* wrapped;
+
+	// Streams the pass-through operations forward to. Wrapped wrappers passing all their read
+	// (or write) operations through are skipped when the wrapper is initialized, so that the
+	// cost of a pass-through operation does not depend on the depth of the wrapper chain.
+	comm_stream_t* readTarget;  // available_read, read, readv, wait_readable
+	comm_stream_t* writeTarget; // available_write, write, writev, wait_writable, flush
 };
 
 void _comm_stream_wrapper_init(_comm_stream_wrapper_t* wrapper, comm_stream_t* wrapped, const _comm_stream_wrapper_controller_t* controller, void* data);
 
+/**
+ * Initializes a wrapper overriding some stream operations. 'streamController' must use
+ * _comm_stream_wrapper_on_deinit as deinitializer, and may use the pass-through operations
+ * below for the operations it does not override. Outer wrappers bypass this wrapper for the
+ * read (or write) operations only if all of them are pass-through operations.
+ */
+void _comm_stream_wrapper_init_with(_comm_stream_wrapper_t* wrapper, comm_stream_t* wrapped, const comm_stream_controller_t* streamController, const _comm_stream_wrapper_controller_t* controller, void* data);
+
+void     COMM_CALL _comm_stream_wrapper_on_deinit(comm_obj_t* obj);
+uint32_t COMM_CALL _comm_stream_wrapper_available_read(const comm_stream_t* stream);
+int32_t  COMM_CALL _comm_stream_wrapper_read(comm_stream_t* stream, void* out, uint32_t len);
+uint32_t COMM_CALL _comm_stream_wrapper_available_write(const comm_stream_t* stream);
+int32_t  COMM_CALL _comm_stream_wrapper_write(comm_stream_t* stream, const void* in, uint32_t len);
+int32_t  COMM_CALL _comm_stream_wrapper_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+int32_t  COMM_CALL _comm_stream_wrapper_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count);
+bool     COMM_CALL _comm_stream_wrapper_wait_readable(comm_stream_t* stream, uint32_t timeoutMs);
+bool     COMM_CALL _comm_stream_wrapper_wait_writable(comm_stream_t* stream, uint32_t timeoutMs);
+bool     COMM_CALL _comm_stream_wrapper_flush(comm_stream_t* stream);
+bool     COMM_CALL _comm_stream_wrapper_close(comm_stream_t* stream);
+
 _comm_stream_wrapper_t* _comm_stream_wrapper_new(comm_stream_t* wrapped, const _comm_stream_wrapper_controller_t* controller, void* data);
+
+/** @return Innermost stream of a wrapper chain (or 'stream' itself if it is not a wrapper). */
+comm_stream_t* _comm_stream_wrapper_unwrap(comm_stream_t* stream);
+
+/**
+ * @return Whether comm_stream_wait_writable() may actually wait for 'stream', i.e. whether the
+ *         innermost stream written by a wrapper chain has a writable-wait operation.
+ */
+bool _comm_stream_wrapper_can_wait_writable(const comm_stream_t* stream);
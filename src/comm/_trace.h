@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+// Static tracepoints. When _COMM_TRACE is defined to a non-zero value in comm_config.h, probes
+// are emitted as USDT probes of provider "comm" through <sys/sdt.h> (systemtap-sdt-dev), usable
+// with perf/bpftrace (e.g. 'bpftrace -e "usdt:./app:comm:stream_read_return { ... }"'). Otherwise
+// they expand to nothing.
+//
+// Probes (stream_* probes are emitted by public comm_stream_*() calls, not by internal hops
+// between wrappers):
+//   stream_read_entry(stream, len)     stream_read_return(stream, result)
+//   stream_write_entry(stream, len)    stream_write_return(stream, result)
+//   stream_flush_entry(stream)         stream_flush_return(stream, result)
+//   line_frame(lineStream, len)        packet_frame(packetStream, len)
+//   mem_alloc(size, ptr)
+
+#if defined __has_include
+	#if __has_include (<comm_config.h>)
+		#include <comm_config.h>
+	#endif
+#endif
+
+#ifndef _COMM_TRACE
+	#define _COMM_TRACE 0
+#endif
+
+#if _COMM_TRACE
+	#include <sys/sdt.h>
+
+	#define _COMM_TRACE1(name, a)    DTRACE_PROBE1(comm, name, a)
+	#define _COMM_TRACE2(name, a, b) DTRACE_PROBE2(comm, name, a, b)
+#else
+	#define _COMM_TRACE1(name, a)    do {} while (0)
+	#define _COMM_TRACE2(name, a, b) do {} while (0)
+#endif
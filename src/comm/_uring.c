@@ -0,0 +1,392 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_uring.h"
+#include "_mem.h"
+
+#if defined __has_include
+	#if __has_include (<comm_config.h>)
+		#include <comm_config.h>
+	#endif
+#endif
+
+#ifndef _COMM_REACTOR_URING
+	#if defined(__linux__) && defined(__has_include)
+		#if __has_include (<linux/io_uring.h>)
+			#define _COMM_REACTOR_URING 1
+		#endif
+	#endif
+#endif
+
+#ifndef _COMM_REACTOR_URING
+	#define _COMM_REACTOR_URING 0
+#endif
+
+#if _COMM_REACTOR_URING
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define __LOAD_ACQUIRE(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define __STORE_RELEASE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+
+struct _comm_uring {
+	int fd;
+
+	// Submission queue
+	void*     sqRing;
+	size_t    sqRingSize;
+	uint32_t* sqHead;
+	uint32_t* sqTail;
+	uint32_t  sqMask;
+	uint32_t  sqEntries;
+	uint32_t* sqArray;
+	struct io_uring_sqe* sqes;
+	size_t    sqesSize;
+
+	// Completion queue
+	void*     cqRing;
+	size_t    cqRingSize;
+	uint32_t* cqHead;
+	uint32_t* cqTail;
+	uint32_t  cqMask;
+	struct io_uring_cqe* cqes;
+};
+
+static int __enter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags, const void* arg, size_t argSize) {
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+// Requests queued but not yet consumed by the kernel
+static uint32_t __pending(const _comm_uring_t* ring) {
+	return *ring->sqTail - __LOAD_ACQUIRE(ring->sqHead);
+}
+
+static bool __submit(_comm_uring_t* ring, uint32_t minComplete, const struct io_uring_getevents_arg* arg) {
+	uint32_t flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+	int result;
+
+	if (arg)
+		flags |= IORING_ENTER_EXT_ARG;
+
+	do {
+		result = __enter(ring->fd, __pending(ring), minComplete, flags, arg, arg ? sizeof(*arg) : 0);
+	} while (result < 0 && errno == EINTR);
+
+	return result >= 0 || errno == ETIME; // Wait timeout is not an error
+}
+
+static struct io_uring_sqe* __acquire_sqe(_comm_uring_t* ring) {
+	uint32_t tail = *ring->sqTail;
+
+	if (__pending(ring) == ring->sqEntries) {
+		// Ring is full: make room by submitting what is queued
+		if (!__submit(ring, 0, NULL) || __pending(ring) == ring->sqEntries)
+			return NULL;
+	}
+
+	struct io_uring_sqe* sqe = &ring->sqes[tail & ring->sqMask];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sqArray[tail & ring->sqMask] = tail & ring->sqMask;
+
+	return sqe;
+}
+
+static void __publish_sqe(_comm_uring_t* ring) {
+	__STORE_RELEASE(ring->sqTail, *ring->sqTail + 1);
+}
+
+_comm_uring_t* _comm_uring_new(uint32_t entries) {
+	struct io_uring_params params;
+	int mErrno = errno;
+
+	_comm_uring_t* ring = _comm_mem_alloc(sizeof(_comm_uring_t));
+
+	if (!ring)
+		goto error;
+
+	memset(ring, 0, sizeof(*ring));
+	memset(&params, 0, sizeof(params));
+
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+
+	if (ring->fd < 0)
+		goto error;
+
+	// Wait timeouts are passed directly to io_uring_enter()
+	if (!(params.features & IORING_FEAT_EXT_ARG))
+		goto error;
+
+	ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cqRingSize > ring->sqRingSize)
+			ring->sqRingSize = ring->cqRingSize;
+
+		ring->cqRingSize = ring->sqRingSize;
+	}
+
+	ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+	if (ring->sqRing == MAP_FAILED) {
+		ring->sqRing = NULL;
+		goto error;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cqRing = ring->sqRing;
+	} else {
+		ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+
+		if (ring->cqRing == MAP_FAILED) {
+			ring->cqRing = NULL;
+			goto error;
+		}
+	}
+
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto error;
+	}
+
+	uint8_t* sq = ring->sqRing;
+	uint8_t* cq = ring->cqRing;
+
+	ring->sqHead    = (uint32_t*)(sq + params.sq_off.head);
+	ring->sqTail    = (uint32_t*)(sq + params.sq_off.tail);
+	ring->sqMask    = *(uint32_t*)(sq + params.sq_off.ring_mask);
+	ring->sqEntries = *(uint32_t*)(sq + params.sq_off.ring_entries);
+	ring->sqArray   = (uint32_t*)(sq + params.sq_off.array);
+	ring->cqHead    = (uint32_t*)(cq + params.cq_off.head);
+	ring->cqTail    = (uint32_t*)(cq + params.cq_off.tail);
+	ring->cqMask    = *(uint32_t*)(cq + params.cq_off.ring_mask);
+	ring->cqes      = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	return ring;
+
+error:
+	if (ring)
+		_comm_uring_del(ring);
+
+	errno = mErrno;
+	return NULL;
+}
+
+void _comm_uring_del(_comm_uring_t* ring) {
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqesSize);
+
+	if (ring->cqRing && ring->cqRing != ring->sqRing)
+		munmap(ring->cqRing, ring->cqRingSize);
+
+	if (ring->sqRing)
+		munmap(ring->sqRing, ring->sqRingSize);
+
+	if (ring->fd >= 0)
+		close(ring->fd);
+
+	_comm_mem_free(ring);
+}
+
+bool _comm_uring_read(_comm_uring_t* ring, int fd, bool socket, uint16_t bufferGroup, uint32_t len, uint64_t userData) {
+	struct io_uring_sqe* sqe = __acquire_sqe(ring);
+
+	if (!sqe)
+		return false;
+
+	sqe->opcode = socket ? IORING_OP_RECV : IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->off = socket ? 0 : (uint64_t)-1; // Current file position (must be zero for sockets)
+	sqe->len = len;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = bufferGroup;
+	sqe->user_data = userData;
+
+	__publish_sqe(ring);
+	return true;
+}
+
+bool _comm_uring_write(_comm_uring_t* ring, int fd, bool socket, const struct msghdr* msg, uint64_t userData) {
+	struct io_uring_sqe* sqe = __acquire_sqe(ring);
+
+	if (!sqe)
+		return false;
+
+	sqe->fd = fd;
+	sqe->user_data = userData;
+
+	if (socket) {
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->addr = (uint64_t)(uintptr_t)msg;
+		sqe->len = 1;
+		sqe->msg_flags = MSG_NOSIGNAL;
+	} else {
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->addr = (uint64_t)(uintptr_t)msg->msg_iov;
+		sqe->len = (uint32_t)msg->msg_iovlen;
+		sqe->off = (uint64_t)-1;
+	}
+
+	__publish_sqe(ring);
+	return true;
+}
+
+bool _comm_uring_provide_buffers(_comm_uring_t* ring, void* addr, uint32_t len, uint16_t count, uint16_t bufferGroup, uint16_t firstId, uint64_t userData) {
+	struct io_uring_sqe* sqe = __acquire_sqe(ring);
+
+	if (!sqe)
+		return false;
+
+	sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+	sqe->fd = count;
+	sqe->addr = (uint64_t)(uintptr_t)addr;
+	sqe->len = len;
+	sqe->off = firstId;
+	sqe->buf_group = bufferGroup;
+	sqe->user_data = userData;
+
+	__publish_sqe(ring);
+	return true;
+}
+
+bool _comm_uring_cancel(_comm_uring_t* ring, uint64_t targetUserData, uint64_t userData) {
+	struct io_uring_sqe* sqe = __acquire_sqe(ring);
+
+	if (!sqe)
+		return false;
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = targetUserData;
+	sqe->user_data = userData;
+
+	__publish_sqe(ring);
+	return true;
+}
+
+bool _comm_uring_enter(_comm_uring_t* ring, uint32_t timeoutMs) {
+	if (timeoutMs == 0 || __LOAD_ACQUIRE(ring->cqTail) != *ring->cqHead)
+		return __pending(ring) == 0 || __submit(ring, 0, NULL);
+
+	if (timeoutMs == UINT32_MAX)
+		return __submit(ring, 1, NULL);
+
+	struct __kernel_timespec ts = {
+		.tv_sec  = timeoutMs / 1000,
+		.tv_nsec = (timeoutMs % 1000) * 1000000ll
+	};
+	struct io_uring_getevents_arg arg = {
+		.ts = (uint64_t)(uintptr_t)&ts
+	};
+
+	return __submit(ring, 1, &arg);
+}
+
+bool _comm_uring_next(_comm_uring_t* ring, uint64_t* userDataOut, int32_t* resultOut, int32_t* bufferIdOut) {
+	uint32_t head = *ring->cqHead;
+
+	if (head == __LOAD_ACQUIRE(ring->cqTail))
+		return false;
+
+	struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+	*userDataOut = cqe->user_data;
+	*resultOut = cqe->res;
+	*bufferIdOut = (cqe->flags & IORING_CQE_F_BUFFER) ? (int32_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+	__STORE_RELEASE(ring->cqHead, head + 1);
+	return true;
+}
+#else
+_comm_uring_t* _comm_uring_new(uint32_t entries) {
+	(void)entries;
+
+	return NULL;
+}
+
+void _comm_uring_del(_comm_uring_t* ring) {
+	(void)ring;
+}
+
+bool _comm_uring_read(_comm_uring_t* ring, int fd, bool socket, uint16_t bufferGroup, uint32_t len, uint64_t userData) {
+	(void)ring;
+	(void)fd;
+	(void)socket;
+	(void)bufferGroup;
+	(void)len;
+	(void)userData;
+
+	return false;
+}
+
+bool _comm_uring_write(_comm_uring_t* ring, int fd, bool socket, const struct msghdr* msg, uint64_t userData) {
+	(void)ring;
+	(void)fd;
+	(void)socket;
+	(void)msg;
+	(void)userData;
+
+	return false;
+}
+
+bool _comm_uring_provide_buffers(_comm_uring_t* ring, void* addr, uint32_t len, uint16_t count, uint16_t bufferGroup, uint16_t firstId, uint64_t userData) {
+	(void)ring;
+	(void)addr;
+	(void)len;
+	(void)count;
+	(void)bufferGroup;
+	(void)firstId;
+	(void)userData;
+
+	return false;
+}
+
+bool _comm_uring_cancel(_comm_uring_t* ring, uint64_t targetUserData, uint64_t userData) {
+	(void)ring;
+	(void)targetUserData;
+	(void)userData;
+
+	return false;
+}
+
+bool _comm_uring_enter(_comm_uring_t* ring, uint32_t timeoutMs) {
+	(void)ring;
+	(void)timeoutMs;
+
+	return false;
+}
+
+bool _comm_uring_next(_comm_uring_t* ring, uint64_t* userDataOut, int32_t* resultOut, int32_t* bufferIdOut) {
+	(void)ring;
+	(void)userDataOut;
+	(void)resultOut;
+	(void)bufferIdOut;
+
+	return false;
+}
+#endif
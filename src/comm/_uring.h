@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+
+#include <comm/defs.h>
+
+typedef struct _comm_uring _comm_uring_t;
+
+/**
+ * Creates a minimal io_uring instance (raw system calls, no liburing).
+ *
+ * @return Ring, or NULL if io_uring is not supported (disabled at build time, missing kernel
+ *         support or blocked by the sandbox). errno is left untouched in that case.
+ */
+_comm_uring_t* _comm_uring_new(uint32_t entries);
+
+void _comm_uring_del(_comm_uring_t* ring);
+
+struct msghdr;
+
+/**
+ * Queues a read (recv(2) for sockets) into a buffer picked by the kernel from those provided
+ * for 'bufferGroup' (see _comm_uring_provide_buffers()). Queued requests are submitted by
+ * _comm_uring_enter().
+ */
+bool _comm_uring_read(_comm_uring_t* ring, int fd, bool socket, uint16_t bufferGroup, uint32_t len, uint64_t userData);
+
+/**
+ * Queues a vectored write (sendmsg(2) for sockets) of the regions described by 'msg', which must
+ * remain valid until the request completes.
+ */
+bool _comm_uring_write(_comm_uring_t* ring, int fd, bool socket, const struct msghdr* msg, uint64_t userData);
+
+/** Queues handing 'count' buffers of 'len' bytes each, starting at 'addr', to 'bufferGroup'. */
+bool _comm_uring_provide_buffers(_comm_uring_t* ring, void* addr, uint32_t len, uint16_t count, uint16_t bufferGroup, uint16_t firstId, uint64_t userData);
+
+/** Queues the cancellation of the request identified by 'targetUserData'. */
+bool _comm_uring_cancel(_comm_uring_t* ring, uint64_t targetUserData, uint64_t userData);
+
+/**
+ * Submits all queued requests and, if 'timeoutMs' is not zero, waits for at least one
+ * completion, using a single system call.
+ */
+bool _comm_uring_enter(_comm_uring_t* ring, uint32_t timeoutMs);
+
+/**
+ * Consumes next completion.
+ *
+ * @param bufferIdOut Receives the id of the provided buffer used by a read, or -1.
+ * @return false if there are no completions.
+ */
+bool _comm_uring_next(_comm_uring_t* ring, uint64_t* userDataOut, int32_t* resultOut, int32_t* bufferIdOut);
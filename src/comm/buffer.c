@@ -22,8 +22,127 @@ SOFTWARE.
 #include "_buffer.h"
 #include "_error.h"
 #include "_mem.h"
+#include "_mirror.h"
 
-#define __MIN(a,b) (a) <= (b) ? (a) : (b)
+#include <string.h>
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+// Power-of-two buffers use free-running cursors (storage index is obtained by masking), so
+// availability is a plain subtraction and full/empty states are never ambiguous. Other buffers
+// keep cursors inside [0, capacity) and rely on 'lastRead' when both cursors are equal.
+
+static inline size_t __index(const _comm_buffer_t* buffer, size_t cursor) {
+	return buffer->mask ? cursor & buffer->mask : cursor;
+}
+
+// Moves a cursor forward by 'len' bytes (len <= capacity), wrapping around the end of storage.
+static inline size_t __advance(const _comm_buffer_t* buffer, size_t cursor, size_t len) {
+	cursor += len;
+
+	if (buffer->mask)
+		return cursor;
+
+	if (cursor >= buffer->capacity)
+		cursor -= buffer->capacity;
+
+	return cursor;
+}
+
+// Splits the 'len' bytes starting at 'cursor' into a head span and an optional wrapped tail span.
+// Mirrored storage is contiguous past its end, so it never needs a tail span.
+static inline size_t __spans(const _comm_buffer_t* buffer, size_t cursor, size_t len, comm_buffer_span_t spans[2]) {
+	size_t index = __index(buffer, cursor);
+	size_t head  = buffer->mirrored ? len : __MIN(len, buffer->capacity - index);
+
+	spans[0].data = buffer->storage + index;
+	spans[0].len  = head;
+	spans[1].data = buffer->storage;
+	spans[1].len  = len - head;
+
+	return len;
+}
+
+static void __reset(_comm_buffer_t* buffer, size_t capacity, bool empty) {
+	bool pow2 = capacity > 1 && (capacity & (capacity - 1)) == 0;
+
+	buffer->capacity = capacity;
+	buffer->mask = pow2 ? capacity - 1 : 0;
+	buffer->readCursor = 0;
+	buffer->writeCursor = (pow2 && !empty) ? capacity : 0;
+	buffer->lastRead = empty;
+}
+
+static void __copy_out(const _comm_buffer_t* buffer, size_t cursor, void* out, size_t len) {
+	comm_buffer_span_t spans[2];
+	__spans(buffer, cursor, len, spans);
+
+	memcpy(out, spans[0].data, spans[0].len);
+
+	if (spans[1].len)
+		memcpy((uint8_t*)out + spans[0].len, spans[1].data, spans[1].len);
+}
+
+static void __copy_in(const _comm_buffer_t* buffer, size_t cursor, const void* in, size_t len) {
+	comm_buffer_span_t spans[2];
+	__spans(buffer, cursor, len, spans);
+
+	memcpy(spans[0].data, in, spans[0].len);
+
+	if (spans[1].len)
+		memcpy(spans[1].data, (const uint8_t*)in + spans[0].len, spans[1].len);
+}
+
+// Searches spans for 'byte', starting at given offset (memchr is vectorized on most platforms).
+static bool __find_from(const comm_buffer_span_t spans[2], uint8_t byte, size_t offset, size_t* offsetOut) {
+	size_t base = 0;
+
+	for (int i = 0; i < 2; i++) {
+		if (offset < base + spans[i].len) {
+			const uint8_t* start = spans[i].data + (offset - base);
+			const uint8_t* found = memchr(start, byte, spans[i].len - (offset - base));
+
+			if (found) {
+				*offsetOut = base + (found - spans[i].data);
+				return true;
+			}
+
+			offset = base + spans[i].len;
+		}
+
+		base += spans[i].len;
+	}
+
+	return false;
+}
+
+static bool __matches(const comm_buffer_span_t spans[2], size_t offset, const uint8_t* pattern, size_t len) {
+	for (int i = 0; i < 2 && len; i++) {
+		if (offset >= spans[i].len) {
+			offset -= spans[i].len;
+			continue;
+		}
+
+		size_t n = __MIN(len, spans[i].len - offset);
+
+		if (memcmp(spans[i].data + offset, pattern, n) != 0)
+			return false;
+
+		pattern += n;
+		len -= n;
+		offset = 0;
+	}
+
+	return len == 0;
+}
+
+static void __free_storage(_comm_buffer_t* buffer) {
+	if (buffer->mirrored) {
+		_comm_mirror_free(buffer->storage, buffer->capacity);
+	} else if (!buffer->wrapped && buffer->storage) {
+		_comm_mem_free(buffer->storage);
+	}
+}
 
 static void COMM_CALL __on_deinit(comm_obj_t* obj) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*)obj;
@@ -31,15 +150,15 @@ static void COMM_CALL __on_deinit(comm_obj_t* obj) {
 	if (buffer->controller && buffer->controller->on_deinit)
 		buffer->controller->on_deinit(obj);
 
-	if (!buffer->wrapped && buffer->storage) {
-		_comm_mem_free(buffer->storage);
-	}
+	__free_storage(buffer);
 }
 
-static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
+uint32_t COMM_CALL _comm_buffer_available_read(const comm_stream_t* stream) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
 
-	if (buffer->writeCursor < buffer->readCursor) {
+	if (buffer->mask) {
+		return buffer->writeCursor - buffer->readCursor;
+	} else if (buffer->writeCursor < buffer->readCursor) {
 		return (buffer->capacity - buffer->readCursor + buffer->writeCursor);
 	} else if (buffer->writeCursor > buffer->readCursor) {
 		return buffer->writeCursor - buffer->readCursor;
@@ -48,38 +167,56 @@ static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
 	}
 }
 
-static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
+int32_t COMM_CALL _comm_buffer_read(comm_stream_t* stream, void* out, uint32_t len) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
 
-	size_t availableRead = __available_read(stream);
-	uint8_t* mOut        = (uint8_t*)out;
+	size_t availableRead = _comm_buffer_available_read(stream);
 
 	len = __MIN(len, availableRead);
 
 	if (len == 0)
 		return 0;
 
-	for (size_t i = 0; i < len; ++i) {
-		if (mOut != NULL) {
-			mOut[i] = buffer->storage[buffer->readCursor];
-		}
+	if (out)
+		__copy_out(buffer, buffer->readCursor, out, len);
 
-		buffer->readCursor++;
+	buffer->readCursor = __advance(buffer, buffer->readCursor, len);
+	buffer->lastRead = true;
 
-		if (buffer->readCursor == buffer->capacity) {
-			buffer->readCursor = 0;
-		}
+	return len;
+}
+
+int32_t COMM_CALL _comm_buffer_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
+
+	size_t availableRead = _comm_buffer_available_read(stream);
+	size_t cursor = buffer->readCursor;
+	size_t total = 0;
+
+	for (uint32_t i = 0; i < count && total < availableRead; i++) {
+		size_t len = __MIN(vec[i].len, availableRead - total);
+
+		if (len && vec[i].data)
+			__copy_out(buffer, cursor, vec[i].data, len);
+
+		cursor = __advance(buffer, cursor, len);
+		total += len;
 	}
 
-	buffer->lastRead = true;
+	if (total) {
+		buffer->readCursor = cursor;
+		buffer->lastRead = true;
+	}
 
-	return len;
+	return total;
 }
 
-static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+uint32_t COMM_CALL _comm_buffer_available_write(const comm_stream_t* stream) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
 
-	if (buffer->writeCursor < buffer->readCursor) {
+	if (buffer->mask) {
+		return buffer->capacity - (buffer->writeCursor - buffer->readCursor);
+	} else if (buffer->writeCursor < buffer->readCursor) {
 		return (buffer->readCursor - buffer->writeCursor);
 	} else if (buffer->writeCursor > buffer->readCursor) {
 		return (buffer->capacity - buffer->writeCursor + buffer->readCursor);
@@ -88,69 +225,98 @@ static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
 	}
 }
 
-static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+int32_t COMM_CALL _comm_buffer_write(comm_stream_t* stream, const void* in, uint32_t len) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
 
-	size_t   availableWrite = __available_write(stream);
-	uint8_t* mIn            = (uint8_t*)in;
+	size_t availableWrite = _comm_buffer_available_write(stream);
 
 	len = __MIN(len, availableWrite);
 
 	if (len == 0)
 		return 0;
 
-	for (size_t i = 0; i < len; ++i) {
-		buffer->storage[buffer->writeCursor] = mIn[i];
-		buffer->writeCursor++;
-
-		if (buffer->writeCursor == buffer->capacity)
-			buffer->writeCursor = 0;
-	}
+	__copy_in(buffer, buffer->writeCursor, in, len);
 
+	buffer->writeCursor = __advance(buffer, buffer->writeCursor, len);
 	buffer->lastRead = false;
+
 	return len;
 }
 
-COMM_PUBLIC comm_buffer_t* COMM_CALL comm_buffer_new(size_t capacity, const comm_buffer_controller_t* controller, void* data) {
-	static comm_stream_controller_t mController = {
-		.objController.on_deinit = __on_deinit,
+int32_t COMM_CALL _comm_buffer_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	_comm_buffer_t* buffer = (_comm_buffer_t*)stream;
+
+	size_t availableWrite = _comm_buffer_available_write(stream);
+	size_t cursor = buffer->writeCursor;
+	size_t total = 0;
+
+	for (uint32_t i = 0; i < count && total < availableWrite; i++) {
+		size_t len = __MIN(vec[i].len, availableWrite - total);
+
+		if (len)
+			__copy_in(buffer, cursor, vec[i].data, len);
 
-		.available_read   = __available_read,
-		.read             = __read,
-		.available_write  = __available_write,
-		.write            = __write
-	};
+		cursor = __advance(buffer, cursor, len);
+		total += len;
+	}
+
+	if (total) {
+		buffer->writeCursor = cursor;
+		buffer->lastRead = false;
+	}
+
+	return total;
+}
 
+const comm_stream_controller_t _comm_buffer_controller = {
+	.objController.on_deinit = __on_deinit,
+
+	.available_read   = _comm_buffer_available_read,
+	.read             = _comm_buffer_read,
+	.available_write  = _comm_buffer_available_write,
+	.write            = _comm_buffer_write,
+	.readv            = _comm_buffer_readv,
+	.writev           = _comm_buffer_writev
+};
+
+static comm_buffer_t* __new(size_t capacity, bool mirror, const comm_buffer_controller_t* controller, void* data) {
 	_comm_buffer_t* buffer = _comm_mem_alloc(sizeof(_comm_buffer_t));
 
 	if (!buffer)
 		goto error;
 
-	buffer->storage = capacity ? _comm_mem_alloc(capacity) : NULL;
+	buffer->storage  = mirror ? _comm_mirror_alloc(capacity) : NULL;
+	buffer->mirrored = buffer->storage != NULL;
 
-	if (capacity && !buffer->storage)
-		goto error;
+	if (!buffer->mirrored) {
+		buffer->storage = capacity ? _comm_mem_alloc(capacity) : NULL;
+
+		if (capacity && !buffer->storage)
+			goto error;
+	}
 
 	buffer->controller = controller;
-	buffer->capacity = capacity;
-	buffer->readCursor = 0;
-	buffer->writeCursor = 0;
-	buffer->lastRead = true;
 	buffer->wrapped = false;
+	__reset(buffer, capacity, true);
 
-	_comm_stream_init((comm_stream_t*)buffer, &mController, data);
+	_comm_stream_init((comm_stream_t*)buffer, &_comm_buffer_controller, data);
 	return (comm_buffer_t*)buffer;
 
 error:
-	if (buffer) {
-		if (buffer->storage) {
-			_comm_mem_free(buffer->storage);
-		}
-	}
+	if (buffer)
+		_comm_mem_free(buffer);
 
 	return NULL;
 }
 
+COMM_PUBLIC comm_buffer_t* COMM_CALL comm_buffer_new(size_t capacity, const comm_buffer_controller_t* controller, void* data) {
+	return __new(capacity, false, controller, data);
+}
+
+COMM_PUBLIC comm_buffer_t* COMM_CALL comm_buffer_new_mirrored(size_t capacity, const comm_buffer_controller_t* controller, void* data) {
+	return __new(capacity, true, controller, data);
+}
+
 COMM_PUBLIC bool COMM_CALL comm_buffer_set_storage(comm_buffer_t* xBuffer, uint8_t* storage, size_t capacity, bool empty) {
 	if (!storage && capacity) {
 		errno = COMM_ERROR_INVPARAM;
@@ -159,16 +325,12 @@ COMM_PUBLIC bool COMM_CALL comm_buffer_set_storage(comm_buffer_t* xBuffer, uint8
 
 	_comm_buffer_t* buffer = (_comm_buffer_t*) xBuffer;
 
-	if (!buffer->wrapped && buffer->storage) {
-		_comm_mem_free(buffer->storage);
-	}
+	__free_storage(buffer);
 
 	buffer->wrapped = storage != NULL;
+	buffer->mirrored = false;
 	buffer->storage = storage;
-	buffer->capacity = capacity;
-	buffer->readCursor = 0;
-	buffer->writeCursor = 0;
-	buffer->lastRead = empty;
+	__reset(buffer, capacity, empty);
 
 	return buffer;
 }
@@ -180,7 +342,92 @@ COMM_PUBLIC size_t COMM_CALL comm_buffer_capacity(const comm_buffer_t* xBuffer)
 COMM_PUBLIC void COMM_CALL comm_buffer_clear(comm_buffer_t* xBuffer) {
 	_comm_buffer_t* buffer = (_comm_buffer_t*) xBuffer;
 
-	buffer->readCursor = 0;
-	buffer->writeCursor = 0;
-	buffer->lastRead = true;
+	__reset(buffer, buffer->capacity, true);
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_buffer_write_acquire(comm_buffer_t* xBuffer, comm_buffer_span_t spans[2]) {
+	_comm_buffer_t* buffer = (_comm_buffer_t*) xBuffer;
+
+	return __spans(buffer, buffer->writeCursor, _comm_buffer_available_write(xBuffer), spans);
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_write_commit(comm_buffer_t* xBuffer, size_t len) {
+	_comm_buffer_t* buffer = (_comm_buffer_t*) xBuffer;
+
+	if (len > _comm_buffer_available_write(xBuffer)) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	if (len) {
+		buffer->writeCursor = __advance(buffer, buffer->writeCursor, len);
+		buffer->lastRead = false;
+	}
+
+	return true;
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_buffer_read_peek(const comm_buffer_t* xBuffer, comm_buffer_span_t spans[2]) {
+	const _comm_buffer_t* buffer = (const _comm_buffer_t*) xBuffer;
+
+	return __spans(buffer, buffer->readCursor, _comm_buffer_available_read(xBuffer), spans);
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_read_release(comm_buffer_t* xBuffer, size_t len) {
+	_comm_buffer_t* buffer = (_comm_buffer_t*) xBuffer;
+
+	if (len > _comm_buffer_available_read(xBuffer)) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	if (len) {
+		buffer->readCursor = __advance(buffer, buffer->readCursor, len);
+		buffer->lastRead = true;
+	}
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_find(const comm_buffer_t* xBuffer, uint8_t byte, size_t* offsetOut) {
+	comm_buffer_span_t spans[2];
+	size_t offset;
+
+	comm_buffer_read_peek(xBuffer, spans);
+
+	if (!__find_from(spans, byte, 0, &offset))
+		return false;
+
+	if (offsetOut)
+		*offsetOut = offset;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffer_find_pattern(const comm_buffer_t* xBuffer, const void* pattern, size_t len, size_t* offsetOut) {
+	if (!pattern || len == 0) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	comm_buffer_span_t spans[2];
+	const uint8_t* mPattern = (const uint8_t*)pattern;
+	size_t available = comm_buffer_read_peek(xBuffer, spans);
+	size_t offset = 0;
+
+	while (__find_from(spans, mPattern[0], offset, &offset)) {
+		if (offset + len > available)
+			return false;
+
+		if (__matches(spans, offset, mPattern, len)) {
+			if (offsetOut)
+				*offsetOut = offset;
+
+			return true;
+		}
+
+		offset++;
+	}
+
+	return false;
 }
@@ -0,0 +1,317 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_stream_wrapper.h"
+#include "_stream_dispatch.h"
+#include "_time.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/buffered_stream.h>
+#include <string.h>
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+typedef struct __buffered_stream __buffered_stream_t;
+
+struct __buffered_stream {
+	_comm_stream_wrapper_t wrapper;
+
+	uint8_t* readBlock;
+	uint32_t readCapacity;
+	uint32_t readPos;
+	uint32_t readLen;
+
+	uint8_t* writeBlock;
+	uint32_t writeCapacity;
+	uint32_t writeLen;
+
+	uint32_t flushPolicy;
+	uint32_t flushParam;
+	uint64_t pendingSinceUs;  // When buffered output became non-empty
+	uint64_t transferredAtUs; // Last time output was transferred into wrapped stream
+
+	uint8_t storage[];
+};
+
+#define __WRAPPED(stream) (((_comm_stream_wrapper_t*)(stream))->wrapped)
+
+// Transfers buffered output into the wrapped stream. When 'block' is false, stops as soon as
+// the wrapped stream does not accept more data.
+static bool __drain(__buffered_stream_t* stream, bool block) {
+	uint32_t offset = 0;
+	bool result = true;
+
+	while (offset < stream->writeLen) {
+		int32_t written = _comm_stream_dispatch_write(__WRAPPED(stream), stream->writeBlock + offset, stream->writeLen - offset);
+
+		if (written < 0) {
+			result = false;
+			break;
+		}
+
+		if (written == 0) {
+			if (!block)
+				break;
+
+			if (!comm_stream_wait_writable(__WRAPPED(stream), COMM_STREAM_WAIT_FOREVER)) {
+				result = false;
+				break;
+			}
+		}
+
+		offset += (uint32_t)written;
+	}
+
+	if (offset > 0) {
+		memmove(stream->writeBlock, stream->writeBlock + offset, stream->writeLen - offset);
+		stream->writeLen -= offset;
+
+		if (stream->flushPolicy >= COMM_BUFFERED_STREAM_FLUSH_DEADLINE)
+			stream->transferredAtUs = _comm_time_now_us();
+	}
+
+	return result;
+}
+
+// @return Time until buffered output is due (0 if it is due now or if there is nothing buffered,
+//         UINT64_MAX if it never becomes due on its own).
+static uint64_t __flush_wait_us(const __buffered_stream_t* stream) {
+	if (stream->writeLen == 0)
+		return 0;
+
+	switch (stream->flushPolicy) {
+	case COMM_BUFFERED_STREAM_FLUSH_THRESHOLD:
+		return stream->writeLen >= stream->flushParam ? 0 : UINT64_MAX;
+
+	case COMM_BUFFERED_STREAM_FLUSH_DEADLINE:
+	case COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE: {
+		uint64_t now = _comm_time_now_us();
+
+		if (stream->flushPolicy == COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE && now - stream->transferredAtUs >= stream->flushParam)
+			return 0; // Idle link: favor latency
+
+		uint64_t age = now - stream->pendingSinceUs;
+		return age >= stream->flushParam ? 0 : stream->flushParam - age;
+	}
+
+	default:
+		return 0;
+	}
+}
+
+// @return true if buffered output has outlived the deadline of a deadline-based policy.
+static bool __overdue(const __buffered_stream_t* stream) {
+	return stream->writeLen > 0 && stream->flushPolicy >= COMM_BUFFERED_STREAM_FLUSH_DEADLINE && _comm_time_now_us() - stream->pendingSinceUs >= stream->flushParam;
+}
+
+static bool __sync(__buffered_stream_t* stream) {
+	return __drain(stream, true) && _comm_stream_dispatch_flush(__WRAPPED(stream));
+}
+
+static uint32_t COMM_CALL __available_read(const comm_stream_t* xStream) {
+	const __buffered_stream_t* stream = (const __buffered_stream_t*)xStream;
+	uint32_t buffered = stream->readLen - stream->readPos;
+	uint32_t available = _comm_stream_dispatch_available_read(__WRAPPED(stream));
+
+	return available > UINT32_MAX - buffered ? UINT32_MAX : buffered + available;
+}
+
+static int32_t COMM_CALL __read(comm_stream_t* xStream, void* out, uint32_t len) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	if (stream->readPos == stream->readLen) {
+		// Large reads bypass the read-ahead block
+		if (len >= stream->readCapacity)
+			return _comm_stream_dispatch_read(__WRAPPED(stream), out, len);
+
+		int32_t read = _comm_stream_dispatch_read(__WRAPPED(stream), stream->readBlock, stream->readCapacity);
+
+		if (read <= 0)
+			return read;
+
+		stream->readPos = 0;
+		stream->readLen = (uint32_t)read;
+	}
+
+	len = __MIN(len, stream->readLen - stream->readPos);
+
+	if (out)
+		memcpy(out, stream->readBlock + stream->readPos, len);
+
+	stream->readPos += len;
+	return (int32_t)len;
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* xStream) {
+	const __buffered_stream_t* stream = (const __buffered_stream_t*)xStream;
+
+	if (stream->writeLen < stream->writeCapacity)
+		return stream->writeCapacity - stream->writeLen;
+
+	return _comm_stream_dispatch_available_write(__WRAPPED(stream));
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* xStream, const void* in, uint32_t len) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	if (len > INT32_MAX)
+		len = INT32_MAX;
+
+	// Writes transfer overdue output (without waiting), so that deadlines hold while the stream is
+	// being written even if it is not flushed
+	if (__overdue(stream)) {
+		uint32_t pending = stream->writeLen;
+
+		if (!__drain(stream, false) || (stream->writeLen < pending && !_comm_stream_dispatch_flush(__WRAPPED(stream))))
+			return -1;
+	}
+
+	if (stream->writeLen + len > stream->writeCapacity) {
+		if (!__drain(stream, false))
+			return -1;
+
+		// Large writes bypass the write block once it is empty
+		if (stream->writeLen == 0 && len >= stream->writeCapacity)
+			return _comm_stream_dispatch_write(__WRAPPED(stream), in, len);
+	}
+
+	len = __MIN(len, stream->writeCapacity - stream->writeLen);
+
+	if (stream->writeLen == 0 && len > 0 && stream->flushPolicy >= COMM_BUFFERED_STREAM_FLUSH_DEADLINE)
+		stream->pendingSinceUs = _comm_time_now_us();
+
+	memcpy(stream->writeBlock + stream->writeLen, in, len);
+	stream->writeLen += len;
+
+	return (int32_t)len;
+}
+
+static bool COMM_CALL __flush(comm_stream_t* xStream) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	if (__flush_wait_us(stream) > 0)
+		return true; // Deferred by flush policy
+
+	return __sync(stream);
+}
+
+static bool COMM_CALL __close(comm_stream_t* xStream) {
+	return __drain((__buffered_stream_t*)xStream, true) && _comm_stream_wrapper_close(xStream);
+}
+
+static bool COMM_CALL __wait_readable(comm_stream_t* xStream, uint32_t timeoutMs) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	return stream->readPos < stream->readLen || comm_stream_wait_readable(__WRAPPED(stream), timeoutMs);
+}
+
+static bool COMM_CALL __wait_writable(comm_stream_t* xStream, uint32_t timeoutMs) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	return stream->writeLen < stream->writeCapacity || comm_stream_wait_writable(__WRAPPED(stream), timeoutMs);
+}
+
+// Vectored operations use the generic per-region fallback, which copies into the blocks
+static const comm_stream_controller_t __streamController = {
+	.objController.on_deinit = _comm_stream_wrapper_on_deinit,
+
+	.available_read  = __available_read,
+	.read            = __read,
+	.available_write = __available_write,
+	.write           = __write,
+	.flush           = __flush,
+	.close           = __close,
+	.wait_readable   = __wait_readable,
+	.wait_writable   = __wait_writable
+};
+
+COMM_PUBLIC comm_buffered_stream_t* COMM_CALL comm_buffered_stream_new(comm_stream_t* wrapped, uint32_t readBufferSize, uint32_t writeBufferSize, const comm_buffered_stream_controller_t* controller, void* data) {
+	if (!wrapped || (size_t)readBufferSize + writeBufferSize > INT32_MAX) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__buffered_stream_t* stream = _comm_mem_alloc(sizeof(__buffered_stream_t) + readBufferSize + writeBufferSize);
+
+	if (!stream)
+		return NULL;
+
+	stream->readBlock = stream->storage;
+	stream->readCapacity = readBufferSize;
+	stream->readPos = 0;
+	stream->readLen = 0;
+	stream->writeBlock = stream->storage + readBufferSize;
+	stream->writeCapacity = writeBufferSize;
+	stream->writeLen = 0;
+	stream->flushPolicy = COMM_BUFFERED_STREAM_FLUSH_IMMEDIATE;
+	stream->flushParam = 0;
+	stream->pendingSinceUs = 0;
+	stream->transferredAtUs = 0;
+
+	_comm_stream_wrapper_init_with((_comm_stream_wrapper_t*)stream, wrapped, &__streamController, controller, data);
+	return (comm_buffered_stream_t*)stream;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_set_flush_policy(comm_buffered_stream_t* xStream, uint32_t policy, uint32_t param) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+
+	if (policy > COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	stream->flushPolicy = policy;
+	stream->flushParam = param;
+	stream->pendingSinceUs = _comm_time_now_us();
+	stream->transferredAtUs = 0;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_service(comm_buffered_stream_t* xStream, uint32_t* waitUsOut) {
+	__buffered_stream_t* stream = (__buffered_stream_t*)xStream;
+	uint64_t waitUs = UINT64_MAX;
+
+	if (stream->writeLen > 0) {
+		waitUs = __flush_wait_us(stream);
+
+		if (waitUs == 0) {
+			if (!__sync(stream))
+				return false;
+
+			waitUs = stream->writeLen > 0 ? __flush_wait_us(stream) : UINT64_MAX;
+		}
+	}
+
+	if (waitUsOut)
+		*waitUsOut = waitUs > UINT32_MAX ? UINT32_MAX : (uint32_t)waitUs;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_buffered_stream_sync(comm_buffered_stream_t* stream) {
+	return __sync((__buffered_stream_t*)stream);
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_buffered_stream_pending(const comm_buffered_stream_t* stream) {
+	return ((const __buffered_stream_t*)stream)->writeLen;
+}
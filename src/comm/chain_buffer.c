@@ -0,0 +1,341 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_stream.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/chain_buffer.h>
+#include <string.h>
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+#define __DEFAULT_MAX_SPARE 1
+
+typedef struct __chain_buffer __chain_buffer_t;
+typedef struct __chunk        __chunk_t;
+
+struct __chunk {
+	__chunk_t* next;
+	uint8_t    data[];
+};
+
+struct __chain_buffer {
+	comm_stream_t stream;
+
+	const comm_chain_buffer_controller_t* controller;
+	size_t     chunkSize;
+	size_t     maxSize;
+	size_t     size;
+	__chunk_t* head;
+	__chunk_t* tail;
+	__chunk_t* spare;       // Free list of released chunks (linked through 'next')
+	size_t     spareCount;
+	size_t     maxSpare;
+	size_t     readOffset;  // Offset inside head chunk
+	size_t     writeOffset; // Offset inside tail chunk
+};
+
+static __chunk_t* __acquire_chunk(__chain_buffer_t* buffer) {
+	__chunk_t* chunk = buffer->spare;
+
+	if (chunk) {
+		buffer->spare = chunk->next;
+		buffer->spareCount--;
+	} else {
+		chunk = _comm_mem_alloc(sizeof(__chunk_t) + buffer->chunkSize);
+
+		if (!chunk)
+			return NULL;
+	}
+
+	chunk->next = NULL;
+	return chunk;
+}
+
+static void __release_chunk(__chain_buffer_t* buffer, __chunk_t* chunk) {
+	if (buffer->spareCount < buffer->maxSpare) {
+		chunk->next = buffer->spare;
+		buffer->spare = chunk;
+		buffer->spareCount++;
+	} else {
+		_comm_mem_free(chunk);
+	}
+}
+
+// Frees spare chunks beyond 'keep'
+static void __trim_spare(__chain_buffer_t* buffer, size_t keep) {
+	while (buffer->spareCount > keep) {
+		__chunk_t* chunk = buffer->spare;
+
+		buffer->spare = chunk->next;
+		buffer->spareCount--;
+		_comm_mem_free(chunk);
+	}
+}
+
+static void __release_chunks(__chain_buffer_t* buffer) {
+	__chunk_t* chunk = buffer->head;
+
+	while (chunk) {
+		__chunk_t* next = chunk->next;
+		__release_chunk(buffer, chunk);
+		chunk = next;
+	}
+
+	buffer->head = NULL;
+	buffer->tail = NULL;
+	buffer->size = 0;
+	buffer->readOffset = 0;
+	buffer->writeOffset = 0;
+}
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)obj;
+
+	if (buffer->controller && buffer->controller->on_deinit)
+		buffer->controller->on_deinit(obj);
+
+	__release_chunks(buffer);
+	__trim_spare(buffer, 0);
+}
+
+static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
+	return __MIN(((__chain_buffer_t*)stream)->size, UINT32_MAX);
+}
+
+static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)stream;
+	uint8_t* mOut = (uint8_t*)out;
+
+	len = __MIN(__MIN(len, buffer->size), INT32_MAX);
+
+	size_t remaining = len;
+
+	while (remaining) {
+		__chunk_t* chunk = buffer->head;
+		size_t end = chunk == buffer->tail ? buffer->writeOffset : buffer->chunkSize;
+		size_t n = __MIN(remaining, end - buffer->readOffset);
+
+		if (mOut) {
+			memcpy(mOut, chunk->data + buffer->readOffset, n);
+			mOut += n;
+		}
+
+		buffer->readOffset += n;
+		buffer->size -= n;
+		remaining -= n;
+
+		if (buffer->readOffset == buffer->chunkSize) {
+			buffer->head = chunk->next;
+			buffer->readOffset = 0;
+
+			if (!buffer->head)
+				buffer->tail = NULL;
+
+			__release_chunk(buffer, chunk);
+		}
+	}
+
+	// Drained buffers keep no chunk in use
+	if (buffer->size == 0)
+		__release_chunks(buffer);
+
+	__trim_spare(buffer, buffer->maxSpare); // Reserved chunks left unused
+	return len;
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)stream;
+
+	if (!buffer->maxSize)
+		return UINT32_MAX;
+
+	return __MIN(buffer->maxSize - buffer->size, UINT32_MAX);
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)stream;
+	const uint8_t* mIn = (const uint8_t*)in;
+
+	len = __MIN(__MIN(len, __available_write(stream)), INT32_MAX);
+
+	size_t remaining = len;
+
+	while (remaining) {
+		if (!buffer->tail || buffer->writeOffset == buffer->chunkSize) {
+			__chunk_t* chunk = __acquire_chunk(buffer);
+
+			if (!chunk) {
+				if (remaining == len)
+					return -1;
+
+				break;
+			}
+
+			if (buffer->tail) {
+				buffer->tail->next = chunk;
+			} else {
+				buffer->head = chunk;
+			}
+
+			buffer->tail = chunk;
+			buffer->writeOffset = 0;
+		}
+
+		size_t n = __MIN(remaining, buffer->chunkSize - buffer->writeOffset);
+
+		memcpy(buffer->tail->data + buffer->writeOffset, mIn, n);
+
+		mIn += n;
+		buffer->writeOffset += n;
+		buffer->size += n;
+		remaining -= n;
+	}
+
+	__trim_spare(buffer, buffer->maxSpare); // Reserved chunks left unused
+	return len - remaining;
+}
+
+COMM_PUBLIC comm_chain_buffer_t* COMM_CALL comm_chain_buffer_new(size_t chunkSize, size_t maxSize, const comm_chain_buffer_controller_t* controller, void* data) {
+	static comm_stream_controller_t mController = {
+		.objController.on_deinit = __on_deinit,
+
+		.available_read   = __available_read,
+		.read             = __read,
+		.available_write  = __available_write,
+		.write            = __write
+	};
+
+	if (chunkSize == 0) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__chain_buffer_t* buffer = _comm_mem_alloc(sizeof(__chain_buffer_t));
+
+	if (!buffer)
+		return NULL;
+
+	buffer->controller = controller;
+	buffer->chunkSize = chunkSize;
+	buffer->maxSize = maxSize;
+	buffer->head = NULL;
+	buffer->tail = NULL;
+	buffer->spare = NULL;
+	buffer->spareCount = 0;
+	buffer->maxSpare = __DEFAULT_MAX_SPARE;
+	__release_chunks(buffer);
+
+	_comm_stream_init((comm_stream_t*)buffer, &mController, data);
+	return (comm_chain_buffer_t*)buffer;
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_chain_buffer_size(const comm_chain_buffer_t* buffer) {
+	return ((const __chain_buffer_t*)buffer)->size;
+}
+
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_clear(comm_chain_buffer_t* xBuffer) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)xBuffer;
+
+	__release_chunks(buffer);
+	__trim_spare(buffer, buffer->maxSpare);
+}
+
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_set_max_spare(comm_chain_buffer_t* xBuffer, size_t maxSpare) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)xBuffer;
+
+	buffer->maxSpare = maxSpare;
+	__trim_spare(buffer, maxSpare);
+}
+
+COMM_PUBLIC bool COMM_CALL comm_chain_buffer_reserve(comm_chain_buffer_t* xBuffer, size_t len) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)xBuffer;
+	size_t room = buffer->tail ? buffer->chunkSize - buffer->writeOffset : 0;
+	size_t needed = len > room ? (len - room + buffer->chunkSize - 1) / buffer->chunkSize : 0;
+
+	while (buffer->spareCount < needed) {
+		__chunk_t* chunk = _comm_mem_alloc(sizeof(__chunk_t) + buffer->chunkSize);
+
+		if (!chunk)
+			return false;
+
+		chunk->next = buffer->spare;
+		buffer->spare = chunk;
+		buffer->spareCount++;
+	}
+
+	return true;
+}
+
+COMM_PUBLIC void COMM_CALL comm_chain_buffer_truncate(comm_chain_buffer_t* xBuffer, size_t size) {
+	__chain_buffer_t* buffer = (__chain_buffer_t*)xBuffer;
+
+	if (size >= buffer->size)
+		return;
+
+	if (size == 0) {
+		__release_chunks(buffer);
+		return;
+	}
+
+	// Locate the chunk holding the new last byte, then release the ones after it
+	size_t end = buffer->readOffset + size;
+	__chunk_t* tail = buffer->head;
+
+	while (end > buffer->chunkSize) {
+		tail = tail->next;
+		end -= buffer->chunkSize;
+	}
+
+	__chunk_t* chunk = tail->next;
+
+	while (chunk) {
+		__chunk_t* next = chunk->next;
+		__release_chunk(buffer, chunk);
+		chunk = next;
+	}
+
+	tail->next = NULL;
+	buffer->tail = tail;
+	buffer->writeOffset = end;
+	buffer->size = size;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_chain_buffer_peek(const comm_chain_buffer_t* xBuffer, comm_stream_vec_t* vec, uint32_t count) {
+	const __chain_buffer_t* buffer = (const __chain_buffer_t*)xBuffer;
+	const __chunk_t* chunk = buffer->size ? buffer->head : NULL;
+	size_t offset = buffer->readOffset;
+	uint32_t filled = 0;
+
+	while (chunk && filled < count) {
+		size_t end = chunk == buffer->tail ? buffer->writeOffset : buffer->chunkSize;
+
+		vec[filled].data = (void*)(chunk->data + offset);
+		vec[filled].len  = (uint32_t)(end - offset);
+		filled++;
+
+		chunk = chunk == buffer->tail ? NULL : chunk->next;
+		offset = 0;
+	}
+
+	return filled;
+}
@@ -0,0 +1,527 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_fd_stream.h"
+#include "_stream.h"
+#include "_stream_dispatch.h"
+#include "_error.h"
+#include "_mem.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0
+#endif
+
+#define __MAX_VEC     16   // Regions per readv/writev syscall
+#define __DISCARD_LEN 512  // Scratch size for discarding reads
+#define __QUEUE_CHUNK 4096 // Chunk size of queued input/output
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+typedef struct __fd_stream __fd_stream_t;
+
+struct __fd_stream {
+	comm_stream_t stream;
+
+	const comm_fd_stream_controller_t* controller;
+	int      fd;
+	uint32_t flags;
+	bool     socket;
+
+	// Queued I/O (see _comm_fd_stream_attach()). Both queues outlive the attachment until drained.
+	bool   attached;
+	size_t maxOutput;
+	_comm_fd_stream_on_output_t onOutput;
+	void*  onOutputContext;
+	comm_chain_buffer_t* input;  // Bytes received by the reactor, read before the descriptor
+	comm_chain_buffer_t* output; // Bytes waiting for the reactor, written before anything else
+};
+
+static bool __has_input(const __fd_stream_t* fdStream) {
+	return fdStream->input && comm_chain_buffer_size(fdStream->input) > 0;
+}
+
+static bool __has_output(const __fd_stream_t* fdStream) {
+	return fdStream->output && comm_chain_buffer_size(fdStream->output) > 0;
+}
+
+// Room left in the output queue of an attached stream
+static uint32_t __output_room(const __fd_stream_t* fdStream) {
+	size_t size = comm_chain_buffer_size(fdStream->output);
+
+	return size < fdStream->maxOutput ? (uint32_t)__MIN(fdStream->maxOutput - size, INT32_MAX) : 0;
+}
+
+// Maps syscall results to stream results: would-block is not an error but "nothing transferred",
+// and end-of-file on reads is an error.
+static int32_t __result(ssize_t result, bool isRead, uint32_t len, int mErrno) {
+	if (result > 0)
+		return (int32_t)result;
+
+	if (result == 0) {
+		if (isRead && len > 0) {
+			errno = COMM_ERROR_IO;
+			return -1;
+		}
+
+		return 0;
+	}
+
+	if (errno == EAGAIN || errno == EWOULDBLOCK) {
+		errno = mErrno;
+		return 0;
+	}
+
+	return -1;
+}
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)obj;
+
+	if (fdStream->controller && fdStream->controller->on_deinit)
+		fdStream->controller->on_deinit(obj);
+
+	if ((fdStream->flags & COMM_FD_STREAM_CLOSE) && fdStream->fd >= 0)
+		close(fdStream->fd);
+
+	if (fdStream->input)
+		comm_obj_del(fdStream->input);
+
+	if (fdStream->output)
+		comm_obj_del(fdStream->output);
+}
+
+static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
+	const __fd_stream_t* fdStream = (const __fd_stream_t*)stream;
+	int mErrno = errno;
+	int available;
+
+	if (__has_input(fdStream))
+		return (uint32_t)__MIN(comm_chain_buffer_size(fdStream->input), INT32_MAX);
+
+	if (fdStream->attached)
+		return 0;
+
+	if (ioctl(fdStream->fd, FIONREAD, &available) != 0 || available < 0) {
+		errno = mErrno;
+		return 0;
+	}
+
+	return (uint32_t)available;
+}
+
+static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
+	int mErrno = errno;
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+	uint8_t discard[__DISCARD_LEN];
+	ssize_t result;
+
+	if (__has_input(fdStream))
+		return _comm_stream_dispatch_read(fdStream->input, out, len);
+
+	if (fdStream->attached)
+		return 0;
+
+	if (len > INT32_MAX)
+		len = INT32_MAX;
+
+	if (!out) {
+		out = discard;
+		len = len < sizeof(discard) ? len : sizeof(discard);
+	}
+
+	do {
+		result = read(fdStream->fd, out, len);
+	} while (result < 0 && errno == EINTR);
+
+	return __result(result, true, len, mErrno);
+}
+
+static int32_t COMM_CALL __readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	int mErrno = errno;
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+	struct iovec iov[__MAX_VEC];
+	uint32_t len = 0;
+	uint32_t iovCount = count < __MAX_VEC ? count : __MAX_VEC;
+	ssize_t result;
+
+	if (count == 0)
+		return 0;
+
+	if (__has_input(fdStream))
+		return _comm_stream_dispatch_readv(fdStream->input, vec, count);
+
+	if (fdStream->attached)
+		return 0;
+
+	for (uint32_t i = 0; i < iovCount; i++) {
+		if (!vec[i].data) {
+			iovCount = i; // Discarding regions are not supported by readv(2)
+			break;
+		}
+
+		iov[i].iov_base = vec[i].data;
+		iov[i].iov_len  = vec[i].len;
+		len += vec[i].len;
+	}
+
+	// Leading discarding region
+	if (iovCount == 0)
+		return __read(stream, NULL, vec[0].len);
+
+	do {
+		result = readv(fdStream->fd, iov, iovCount);
+	} while (result < 0 && errno == EINTR);
+
+	return __result(result, true, len, mErrno);
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+	const __fd_stream_t* fdStream = (const __fd_stream_t*)stream;
+	struct pollfd pfd = { .fd = fdStream->fd, .events = POLLOUT };
+	int mErrno = errno;
+
+	if (fdStream->attached)
+		return __output_room(fdStream);
+
+	if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLOUT)) {
+		errno = mErrno;
+		return 0;
+	}
+
+	return INT32_MAX; // Actual room is unknown: writes may still be partial
+}
+
+static int32_t __write_fd(__fd_stream_t* fdStream, const void* in, uint32_t len) {
+	int mErrno = errno;
+	ssize_t result;
+
+	if (len > INT32_MAX)
+		len = INT32_MAX;
+
+	do {
+		if (fdStream->socket) {
+			result = send(fdStream->fd, in, len, MSG_NOSIGNAL);
+		} else {
+			result = write(fdStream->fd, in, len);
+		}
+	} while (result < 0 && errno == EINTR);
+
+	return __result(result, false, len, mErrno);
+}
+
+static int32_t __writev_fd(__fd_stream_t* fdStream, const comm_stream_vec_t* vec, uint32_t count) {
+	int mErrno = errno;
+	struct iovec iov[__MAX_VEC];
+	uint32_t len = 0;
+	ssize_t result;
+
+	count = count < __MAX_VEC ? count : __MAX_VEC;
+
+	for (uint32_t i = 0; i < count; i++) {
+		iov[i].iov_base = vec[i].data;
+		iov[i].iov_len  = vec[i].len;
+		len += vec[i].len;
+	}
+
+	do {
+		if (fdStream->socket) {
+			struct msghdr msg = { .msg_iov = iov, .msg_iovlen = count };
+			result = sendmsg(fdStream->fd, &msg, MSG_NOSIGNAL);
+		} else {
+			result = writev(fdStream->fd, iov, count);
+		}
+	} while (result < 0 && errno == EINTR);
+
+	return __result(result, false, len, mErrno);
+}
+
+// Writes output left queued by a reactor, ahead of new data.
+// @return Whether the queue is empty.
+static bool __drain_output(__fd_stream_t* fdStream, bool* failed) {
+	comm_stream_vec_t vec[__MAX_VEC];
+
+	*failed = false;
+
+	while (__has_output(fdStream)) {
+		int32_t written = __writev_fd(fdStream, vec, comm_chain_buffer_peek(fdStream->output, vec, __MAX_VEC));
+
+		if (written <= 0) {
+			*failed = written < 0;
+			return false;
+		}
+
+		_comm_stream_dispatch_read(fdStream->output, NULL, (uint32_t)written);
+	}
+
+	return true;
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+	bool failed;
+
+	if (fdStream->attached) {
+		bool wasEmpty = !__has_output(fdStream);
+		int32_t written = 0;
+
+		len = __MIN(len, __output_room(fdStream));
+
+		if (len)
+			written = _comm_stream_dispatch_write(fdStream->output, in, len);
+
+		if (written > 0 && wasEmpty)
+			fdStream->onOutput(fdStream->onOutputContext);
+
+		return written;
+	}
+
+	if (!__drain_output(fdStream, &failed))
+		return failed ? -1 : 0;
+
+	return __write_fd(fdStream, in, len);
+}
+
+static int32_t COMM_CALL __writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+	bool failed;
+
+	if (fdStream->attached) {
+		bool wasEmpty = !__has_output(fdStream);
+		uint32_t room = __output_room(fdStream);
+		int32_t total = 0;
+
+		for (uint32_t i = 0; i < count && room > 0; i++) {
+			uint32_t len = __MIN(vec[i].len, room);
+
+			if (_comm_stream_dispatch_write(fdStream->output, vec[i].data, len) != (int32_t)len) {
+				if (!total)
+					return -1;
+
+				break;
+			}
+
+			total += len;
+			room -= len;
+		}
+
+		if (total > 0 && wasEmpty)
+			fdStream->onOutput(fdStream->onOutputContext);
+
+		return total;
+	}
+
+	if (!__drain_output(fdStream, &failed))
+		return failed ? -1 : 0;
+
+	return __writev_fd(fdStream, vec, count);
+}
+
+static bool COMM_CALL __flush(comm_stream_t* stream) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+	int mErrno = errno;
+	bool failed;
+
+	// Queued output is submitted by the reactor
+	if (fdStream->attached)
+		return true;
+
+	while (!__drain_output(fdStream, &failed)) {
+		if (failed || !comm_stream_wait_writable(stream, COMM_STREAM_WAIT_FOREVER))
+			return false;
+	}
+
+	if (isatty(fdStream->fd))
+		return tcdrain(fdStream->fd) == 0;
+
+	errno = mErrno; // isatty() sets errno for non-terminals
+	return true;
+}
+
+static bool COMM_CALL __close(comm_stream_t* stream) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+
+	if (fdStream->fd < 0)
+		return true;
+
+	int fd = fdStream->fd;
+	fdStream->fd = -1;
+
+	return close(fd) == 0;
+}
+
+static bool __wait(comm_stream_t* stream, short events, uint32_t timeoutMs) {
+	struct pollfd pfd = { .fd = ((__fd_stream_t*)stream)->fd, .events = events };
+	int mErrno = errno;
+	int result = poll(&pfd, 1, timeoutMs == COMM_STREAM_WAIT_FOREVER ? -1 : (int)(timeoutMs > INT32_MAX ? INT32_MAX : timeoutMs));
+
+	errno = mErrno;
+
+	// Errors (including interruptions) wake the caller, which will then see them when reading/writing
+	return result != 0;
+}
+
+// Attached streams are served by the reactor: there is nothing to wait for
+static bool COMM_CALL __wait_readable(comm_stream_t* stream, uint32_t timeoutMs) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+
+	if (fdStream->attached || __has_input(fdStream))
+		return __has_input(fdStream);
+
+	return __wait(stream, POLLIN, timeoutMs);
+}
+
+static bool COMM_CALL __wait_writable(comm_stream_t* stream, uint32_t timeoutMs) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+
+	if (fdStream->attached)
+		return __output_room(fdStream) > 0;
+
+	return __wait(stream, POLLOUT, timeoutMs);
+}
+
+static const comm_stream_controller_t __streamController = {
+	.objController.on_deinit = __on_deinit,
+
+	.available_read  = __available_read,
+	.read            = __read,
+	.available_write = __available_write,
+	.write           = __write,
+	.flush           = __flush,
+	.close           = __close,
+	.readv           = __readv,
+	.writev          = __writev,
+	.wait_readable   = __wait_readable,
+	.wait_writable   = __wait_writable
+};
+
+COMM_PUBLIC comm_fd_stream_t* COMM_CALL comm_fd_stream_new(int fd, uint32_t flags, const comm_fd_stream_controller_t* controller, void* data) {
+	struct stat st;
+
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	if (flags & COMM_FD_STREAM_NONBLOCK) {
+		int fdFlags = fcntl(fd, F_GETFL);
+
+		if (fdFlags < 0 || fcntl(fd, F_SETFL, fdFlags | O_NONBLOCK) != 0) {
+			errno = COMM_ERROR_IO;
+			return NULL;
+		}
+	}
+
+	__fd_stream_t* fdStream = _comm_mem_alloc(sizeof(__fd_stream_t));
+
+	if (!fdStream)
+		return NULL;
+
+	fdStream->controller = controller;
+	fdStream->fd = fd;
+	fdStream->flags = flags;
+	fdStream->socket = S_ISSOCK(st.st_mode);
+	fdStream->attached = false;
+	fdStream->maxOutput = 0;
+	fdStream->onOutput = NULL;
+	fdStream->onOutputContext = NULL;
+	fdStream->input = NULL;
+	fdStream->output = NULL;
+
+	_comm_stream_init((comm_stream_t*)fdStream, &__streamController, data);
+	return (comm_fd_stream_t*)fdStream;
+}
+
+COMM_PUBLIC int COMM_CALL comm_fd_stream_fd(const comm_stream_t* stream) {
+	if (stream->controller != (const comm_obj_controller_t*)&__streamController)
+		return -1;
+
+	return ((const __fd_stream_t*)stream)->fd;
+}
+
+bool _comm_fd_stream_attach(comm_fd_stream_t* stream, size_t maxOutput, _comm_fd_stream_on_output_t onOutput, void* context) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+
+	if (!fdStream->input && !(fdStream->input = comm_chain_buffer_new(__QUEUE_CHUNK, 0, NULL, NULL)))
+		return false;
+
+	if (!fdStream->output && !(fdStream->output = comm_chain_buffer_new(__QUEUE_CHUNK, 0, NULL, NULL)))
+		return false;
+
+	fdStream->attached = true;
+	fdStream->maxOutput = maxOutput;
+	fdStream->onOutput = onOutput;
+	fdStream->onOutputContext = context;
+
+	return true;
+}
+
+void _comm_fd_stream_detach(comm_fd_stream_t* stream) {
+	__fd_stream_t* fdStream = (__fd_stream_t*)stream;
+
+	fdStream->attached = false;
+	fdStream->onOutput = NULL;
+	fdStream->onOutputContext = NULL;
+}
+
+bool _comm_fd_stream_is_socket(const comm_fd_stream_t* stream) {
+	return ((const __fd_stream_t*)stream)->socket;
+}
+
+bool _comm_fd_stream_receive(comm_fd_stream_t* stream, const void* data, uint32_t len) {
+	return _comm_stream_dispatch_write(((__fd_stream_t*)stream)->input, data, len) == (int32_t)len;
+}
+
+comm_chain_buffer_t* _comm_fd_stream_output(comm_fd_stream_t* stream) {
+	return ((__fd_stream_t*)stream)->output;
+}
+
+bool _comm_fd_stream_is_direct(const comm_fd_stream_t* stream) {
+	const __fd_stream_t* fdStream = (const __fd_stream_t*)stream;
+
+	return !fdStream->attached && !__has_input(fdStream) && !__has_output(fdStream);
+}
+#else
+COMM_PUBLIC comm_fd_stream_t* COMM_CALL comm_fd_stream_new(int fd, uint32_t flags, const comm_fd_stream_controller_t* controller, void* data) {
+	(void)fd;
+	(void)flags;
+	(void)controller;
+	(void)data;
+
+	errno = COMM_ERROR_INVPARAM;
+	return NULL;
+}
+
+COMM_PUBLIC int COMM_CALL comm_fd_stream_fd(const comm_stream_t* stream) {
+	(void)stream;
+
+	return -1;
+}
+#endif
@@ -19,25 +19,30 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
-#include "_stream_wrapper.h"
+#include "_frame_stream.h"
+#include "_stream_dispatch.h"
 #include "_error.h"
 #include "_mem.h"
+#include "_trace.h"
 
 #include <comm/line_stream.h>
+#include <string.h>
 
 #define __LINE_LIMIT     (UINT16_MAX - 1)
 #define __LINE_DELIMITER '\r'
+#define __READ_AHEAD     512 // Buffer room beyond the longest line, so that reads pull several lines at once
 
 typedef struct __line_stream __line_stream_t;
 
 struct __line_stream {
-	_comm_stream_wrapper_t wrapper;
+	_comm_frame_stream_t frameStream;
 
 	const comm_line_stream_controller_t* controller;
-	uint16_t totalRead;
-	bool     blockRead;
+	uint16_t totalRead; // Length of the line being read (starting at lineStart)
 	size_t   lineMaxLen;
-	uint8_t* buffer;
+	uint8_t* buffer;    // Line being read followed by bytes not scanned yet
+	uint32_t lineStart;
+	uint32_t filled;
 };
 
 static void COMM_CALL __on_deinit(comm_obj_t* obj) {
@@ -47,6 +52,7 @@ static void COMM_CALL __on_deinit(comm_obj_t* obj) {
 		lineStream->controller->on_deinit(obj);
 
 	_comm_mem_free(lineStream->buffer);
+	_comm_frame_stream_deinit((_comm_frame_stream_t*)lineStream);
 }
 
 COMM_PUBLIC comm_line_stream_t* COMM_CALL comm_line_stream_new(comm_stream_t* wrapped, size_t lineMaxLen, bool blockRead, const comm_line_stream_controller_t* controller, void* data) {
@@ -66,14 +72,15 @@ COMM_PUBLIC comm_line_stream_t* COMM_CALL comm_line_stream_new(comm_stream_t* wr
 
 	lineStream->controller = controller;
 	lineStream->totalRead = 0;
-	lineStream->blockRead = blockRead;
 	lineStream->lineMaxLen = lineMaxLen;
-	lineStream->buffer = _comm_mem_alloc(lineMaxLen + 1);
+	lineStream->buffer = _comm_mem_alloc(lineMaxLen + 1 + __READ_AHEAD);
+	lineStream->lineStart = 0;
+	lineStream->filled = 0;
 
 	if (!lineStream->buffer)
 		goto error;
 
-	_comm_stream_wrapper_init((_comm_stream_wrapper_t*)lineStream, wrapped, &mWrapperController, data);
+	_comm_frame_stream_init((_comm_frame_stream_t*)lineStream, wrapped, blockRead, &mWrapperController, data);
 
 	return (comm_line_stream_t*)lineStream;
 error:
@@ -88,88 +95,113 @@ error:
 }
 
 COMM_PUBLIC bool COMM_CALL comm_line_stream_write(comm_line_stream_t* xLineStream, const char* msg) {
+	static char newLine = __LINE_DELIMITER;
+
 	if (!msg)
 		msg = "";
 
-	bool endsWithNewLine = false;
-	int32_t written;
-
-	while(*msg) {
-		endsWithNewLine = (*msg == __LINE_DELIMITER);
-		written = comm_stream_write(xLineStream, msg, 1);
-		if (written < 0) goto error;
+	size_t len = strlen(msg);
 
-		if (written > 0) {
-			msg++;
-		}
+	// Line and delimiter must fit into a single gather write
+	if (len > INT32_MAX - 1) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
 	}
 
-	if (!endsWithNewLine) {
-		uint8_t newLine = __LINE_DELIMITER;
-		do {
-			written = comm_stream_write(xLineStream, &newLine, 1);
-			if (written < 0) goto error;
-		} while (written == 0);
+	comm_stream_vec_t vec[2] = {
+		{ .data = (void*)msg, .len = (uint32_t)len },
+		{ .data = &newLine,   .len = 1 }
+	};
+
+	bool endsWithNewLine = len > 0 && msg[len - 1] == __LINE_DELIMITER;
+
+	return _comm_frame_stream_write((_comm_frame_stream_t*)xLineStream, vec, endsWithNewLine ? 1 : 2) && _comm_stream_dispatch_flush(xLineStream);
+}
+
+/**
+ * Scans buffered bytes for the end of the current line. Bytes exceeding lineMaxLen are dropped.
+ *
+ * @return The line (NUL-terminated in place of its delimiter), or NULL if it is not complete yet.
+ */
+static char* __scan(__line_stream_t* lineStream) {
+	uint8_t* scan = lineStream->buffer + lineStream->lineStart + lineStream->totalRead;
+	uint32_t len = lineStream->buffer + lineStream->filled - scan;
+	uint8_t* delimiter = memchr(scan, __LINE_DELIMITER, len);
+	uint32_t lineLen = delimiter ? (uint32_t)(delimiter - scan) : len;
+	uint32_t kept = lineLen;
+
+	if (lineStream->totalRead + kept > lineStream->lineMaxLen) {
+		kept = (uint32_t)(lineStream->lineMaxLen - lineStream->totalRead);
+		memmove(scan + kept, scan + lineLen, len - lineLen);
+		lineStream->filled -= lineLen - kept;
 	}
 
-	return comm_stream_flush(xLineStream);
+	lineStream->totalRead += kept;
 
-error:
-	return false;
+	if (!delimiter)
+		return NULL;
+
+	char* line = (char*)lineStream->buffer + lineStream->lineStart;
+	line[lineStream->totalRead] = '\0';
+	_COMM_TRACE2(line_frame, lineStream, lineStream->totalRead);
+
+	lineStream->lineStart += lineStream->totalRead + 1;
+	lineStream->totalRead = 0;
+
+	return line;
 }
 
 COMM_PUBLIC char* COMM_CALL comm_line_stream_read(comm_line_stream_t* xLineStream) {
 	__line_stream_t* lineStream = (__line_stream_t*)xLineStream;
 
 	int32_t read;
-	uint8_t* out;
-
-	if (lineStream->blockRead) {
-		lineStream->totalRead = 0;
-		out = lineStream->buffer;
-
-		while(true) {
-			read = comm_stream_read(xLineStream, out, 1);
-
-			if (read < 0) goto error;
-			if (read == 0) continue;
-
-			if (*out == __LINE_DELIMITER) {
-				*out = '\0';
-				return (char*)lineStream->buffer;
-			} else {
-				lineStream->totalRead++;
-				if (lineStream->totalRead <= lineStream->lineMaxLen) {
-					out++;
-				} else {
-					lineStream->totalRead = lineStream->lineMaxLen;
-				}
-			}
+	uint32_t len;
+	uint32_t available;
+	char* line;
+
+	while (true) {
+		if ((line = __scan(lineStream)))
+			return line;
+
+		// Everything buffered belongs to the current line: move it to the start and read more
+		if (lineStream->lineStart) {
+			memmove(lineStream->buffer, lineStream->buffer + lineStream->lineStart, lineStream->totalRead);
+			lineStream->lineStart = 0;
+			lineStream->filled = lineStream->totalRead;
 		}
-	} else {
-		while(comm_stream_available_read(xLineStream)) {
-			out = lineStream->buffer + lineStream->totalRead;
-			read = comm_stream_read(xLineStream, out, 1);
 
-			if (read < 0) goto error;
-			if (read == 0) return NULL;
+		// Never ask for more than is available, so that blocking streams do not wait for a full chunk
+		len = (uint32_t)(lineStream->lineMaxLen + 1 + __READ_AHEAD) - lineStream->filled;
+		available = _comm_stream_dispatch_available_read(xLineStream);
+
+		if (available == 0) {
+			if (!lineStream->frameStream.blockRead) return NULL;
+			len = 1;
+		} else if (available < len) {
+			len = available;
+		}
 
-			if (*out == __LINE_DELIMITER) {
-				*out = '\0';
-				lineStream->totalRead = 0;
-				return (char*)lineStream->buffer;
-			}
+		read = _comm_stream_dispatch_read(xLineStream, lineStream->buffer + lineStream->filled, len);
 
-			lineStream->totalRead++;
+		if (read < 0) goto error;
 
-			if (lineStream->totalRead > lineStream->lineMaxLen) {
-				lineStream->totalRead = lineStream->lineMaxLen;
-			}
+		if (read == 0) {
+			if (!lineStream->frameStream.blockRead) return NULL;
+			if (!comm_stream_wait_readable(xLineStream, COMM_STREAM_WAIT_FOREVER)) goto error;
+			continue;
 		}
 
-		return NULL;
+		lineStream->filled += read;
 	}
 
 error:
 	return NULL;
 }
+
+COMM_PUBLIC void COMM_CALL comm_line_stream_set_block_write(comm_line_stream_t* lineStream, bool blockWrite, size_t maxPending) {
+	_comm_frame_stream_set_block_write((_comm_frame_stream_t*)lineStream, blockWrite, maxPending);
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_line_stream_pending(const comm_line_stream_t* lineStream) {
+	return _comm_frame_stream_pending((const _comm_frame_stream_t*)lineStream);
+}
@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_obj.h"
+#include "_stream_dispatch.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/packet_queue.h>
+#include <string.h>
+
+#define __CACHE_LINE_SIZE 64
+
+typedef struct __packet_queue __packet_queue_t;
+typedef struct __slot         __slot_t;
+
+// Slots span whole cache lines, so that producers filling adjacent slots do not share lines
+struct __slot {
+	size_t  sequence;
+	uint8_t frame[256]; // Header + payload
+	uint8_t padding[__CACHE_LINE_SIZE - sizeof(size_t)];
+};
+
+// Bounded queue where each slot carries a sequence number telling which lap of the ring it
+// belongs to: producers claim slots through a CAS on 'enqueuePos' and publish them by bumping
+// the slot sequence, so there is no global lock and a slot is only visible once fully copied.
+struct __packet_queue {
+	comm_obj_t obj;
+
+	const comm_packet_queue_controller_t* controller;
+	comm_stream_t* wrapped;
+	void*          slotsAlloc; // Unaligned allocation holding the slots
+	__slot_t*      slots;
+	size_t         mask;
+
+	uint8_t padding0[__CACHE_LINE_SIZE];
+
+	// Producers
+	size_t enqueuePos;
+
+	uint8_t padding1[__CACHE_LINE_SIZE - sizeof(size_t)];
+
+	// Consumer
+	size_t dequeuePos;
+	size_t drainOffset;
+
+	uint8_t padding2[__CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+};
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__packet_queue_t* queue = (__packet_queue_t*)obj;
+
+	if (queue->controller && queue->controller->on_deinit)
+		queue->controller->on_deinit(obj);
+
+	_comm_mem_free(queue->slotsAlloc);
+}
+
+COMM_PUBLIC comm_packet_queue_t* COMM_CALL comm_packet_queue_new(comm_stream_t* wrapped, size_t slots, const comm_packet_queue_controller_t* controller, void* data) {
+	static comm_obj_controller_t mController = {
+		.on_deinit = __on_deinit
+	};
+
+	if (!wrapped || slots == 0 || (slots & (slots - 1)) != 0) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__packet_queue_t* queue = _comm_mem_alloc(sizeof(__packet_queue_t));
+
+	if (!queue)
+		goto error;
+
+	queue->slotsAlloc = _comm_mem_alloc(slots * sizeof(__slot_t) + __CACHE_LINE_SIZE - 1);
+
+	if (!queue->slotsAlloc)
+		goto error;
+
+	queue->slots = (__slot_t*)(((uintptr_t)queue->slotsAlloc + __CACHE_LINE_SIZE - 1) & ~(uintptr_t)(__CACHE_LINE_SIZE - 1));
+
+	for (size_t i = 0; i < slots; i++)
+		queue->slots[i].sequence = i;
+
+	queue->controller = controller;
+	queue->wrapped = wrapped;
+	queue->mask = slots - 1;
+	queue->enqueuePos = 0;
+	queue->dequeuePos = 0;
+	queue->drainOffset = 0;
+
+	_comm_obj_init((comm_obj_t*)queue, &mController, data);
+	return (comm_packet_queue_t*)queue;
+
+error:
+	if (queue)
+		_comm_mem_free(queue);
+
+	return NULL;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_packet_queue_push(comm_packet_queue_t* xQueue, const void* in, uint8_t len) {
+	if (!in && len) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	__packet_queue_t* queue = (__packet_queue_t*)xQueue;
+	__slot_t* slot;
+	size_t pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+
+	while (true) {
+		slot = &queue->slots[pos & queue->mask];
+
+		size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&queue->enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			errno = COMM_ERROR_AGAIN;
+			return false;
+		} else {
+			pos = __atomic_load_n(&queue->enqueuePos, __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->frame[0] = len;
+
+	if (len)
+		memcpy(slot->frame + 1, in, len);
+
+	__atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+COMM_PUBLIC int32_t COMM_CALL comm_packet_queue_drain(comm_packet_queue_t* xQueue) {
+	__packet_queue_t* queue = (__packet_queue_t*)xQueue;
+	int32_t drained = 0;
+	bool wrote = false;
+	bool failed = false;
+
+	while (true) {
+		__slot_t* slot = &queue->slots[queue->dequeuePos & queue->mask];
+
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != queue->dequeuePos + 1)
+			break; // Empty
+
+		uint32_t frameLen = 1 + slot->frame[0];
+		int32_t written = _comm_stream_dispatch_write(queue->wrapped, slot->frame + queue->drainOffset, frameLen - queue->drainOffset);
+
+		if (written < 0) {
+			failed = true;
+			break;
+		}
+
+		wrote = wrote || written > 0;
+		queue->drainOffset += written;
+
+		if (queue->drainOffset < frameLen)
+			break; // Wrapped stream is full
+
+		queue->drainOffset = 0;
+		__atomic_store_n(&slot->sequence, queue->dequeuePos + queue->mask + 1, __ATOMIC_RELEASE);
+		queue->dequeuePos++;
+		drained++;
+	}
+
+	// Partially written packets are flushed too
+	if (wrote && !_comm_stream_dispatch_flush(queue->wrapped))
+		failed = true;
+
+	if (failed)
+		_COMM_ERROR_SET(COMM_ERROR_IO);
+
+	return drained;
+}
@@ -19,23 +19,26 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
-#include "_stream_wrapper.h"
+#include "_frame_stream.h"
+#include "_stream_dispatch.h"
 #include "_error.h"
 #include "_mem.h"
+#include "_trace.h"
 
 #include <comm/packet_stream.h>
 
-#define __MIN(a,b) (a) <= (b) ? (a) : (b)
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+#define __BATCH_SIZE 16 // Packets per gather write
 
 typedef struct __packet_stream __packet_stream_t;
 
 struct __packet_stream {
-	_comm_stream_wrapper_t wrapper;
+	_comm_frame_stream_t frameStream;
 
 	const comm_packet_stream_controller_t* controller;
 
 	int16_t totalRead;
-	bool    blockRead;
 	uint8_t buffer[256];
 };
 
@@ -44,6 +47,8 @@ static void COMM_CALL __on_deinit(comm_obj_t* obj) {
 
 	if (packetStream->controller && packetStream->controller->on_deinit)
 		packetStream->controller->on_deinit(obj);
+
+	_comm_frame_stream_deinit((_comm_frame_stream_t*)packetStream);
 }
 
 COMM_PUBLIC comm_packet_stream_t* COMM_CALL comm_packet_stream_new(comm_stream_t* wrapped, bool blockRead, const comm_packet_stream_controller_t* controller, void* data) {
@@ -59,9 +64,9 @@ COMM_PUBLIC comm_packet_stream_t* COMM_CALL comm_packet_stream_new(comm_stream_t
 	__packet_stream_t* packetStream = _comm_mem_alloc(sizeof(__packet_stream_t));
 
 	if (packetStream) {
+		packetStream->controller = controller;
 		packetStream->totalRead = -1;
-		packetStream->blockRead = blockRead;
-		_comm_stream_wrapper_init((_comm_stream_wrapper_t*)packetStream, wrapped, &mWrapperController, data);
+		_comm_frame_stream_init((_comm_frame_stream_t*)packetStream, wrapped, blockRead, &mWrapperController, data);
 	}
 
 	return (comm_packet_stream_t*)packetStream;
@@ -73,30 +78,65 @@ COMM_PUBLIC bool COMM_CALL comm_packet_stream_write(comm_packet_stream_t* packet
 		goto error;
 	}
 
-	int32_t written = 0;
+	// Header + payload
+	comm_stream_vec_t vec[2] = {
+		{ .data = &len,      .len = 1   },
+		{ .data = (void*)in, .len = len }
+	};
 
-	// Header
-	do {
-		written = comm_stream_write(packetStream, &len, 1);
-		if (written < 0) goto error;
-	} while (written == 0);
+	if (!_comm_frame_stream_write((_comm_frame_stream_t*)packetStream, vec, len ? 2 : 1))
+		goto error;
 
-	// Payload
-	if (len) {
-		uint32_t totalWritten = 0;
-		written = 0;
-		do {
-			written = comm_stream_write(packetStream, in, len);
+	return _comm_stream_dispatch_flush(packetStream);
+
+error:
+	_COMM_ERROR_SET(COMM_ERROR_IO);
+	return false;
+}
 
-			if (written < 0) goto error;
+COMM_PUBLIC bool COMM_CALL comm_packet_stream_write_batch(comm_packet_stream_t* packetStream, const comm_stream_vec_t* packets, uint32_t count) {
+	uint8_t headers[__BATCH_SIZE];
+	comm_stream_vec_t vec[2 * __BATCH_SIZE];
 
-			totalWritten += written;
-			in           += written;
-			len          -= written;
-		} while (len > 0);
+	for (uint32_t i = 0; i < count; i++) {
+		if (packets[i].len > UINT8_MAX || (!packets[i].data && packets[i].len)) {
+			errno = COMM_ERROR_INVPARAM;
+			goto error;
+		}
+	}
+
+	size_t total = count;
+
+	for (uint32_t i = 0; i < count; i++)
+		total += packets[i].len;
+
+	// With non-blocking writes, the batch is either written or queued as a whole
+	if (!_comm_frame_stream_fits((_comm_frame_stream_t*)packetStream, total))
+		goto error;
+
+	while (count) {
+		uint32_t batchSize = __MIN(count, __BATCH_SIZE);
+		uint32_t vecCount = 0;
+
+		for (uint32_t i = 0; i < batchSize; i++) {
+			headers[i] = (uint8_t)packets[i].len;
+
+			vec[vecCount].data = &headers[i];
+			vec[vecCount].len  = 1;
+			vecCount++;
+
+			if (packets[i].len)
+				vec[vecCount++] = packets[i];
+		}
+
+		if (!_comm_frame_stream_write((_comm_frame_stream_t*)packetStream, vec, vecCount))
+			goto error;
+
+		packets += batchSize;
+		count   -= batchSize;
 	}
 
-	return comm_stream_flush(packetStream);
+	return _comm_stream_dispatch_flush(packetStream);
 
 error:
 	_COMM_ERROR_SET(COMM_ERROR_IO);
@@ -109,13 +149,14 @@ COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* xPa
 	uint8_t  len;
 	uint8_t* out;
 
-	if (packetStream->blockRead) {
+	if (packetStream->frameStream.blockRead) {
 		out = packetStream->buffer;
 
 		// Header
 		do {
-			read = comm_stream_read(xPacketStream, out, 1);
+			read = _comm_stream_dispatch_read(xPacketStream, out, 1);
 			if (read < 0) goto error;
+			if (read == 0 && !comm_stream_wait_readable(xPacketStream, COMM_STREAM_WAIT_FOREVER)) goto error;
 		} while (read == 0);
 
 		// Payload
@@ -124,9 +165,10 @@ COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* xPa
 		out++;
 
 		do {
-			read = comm_stream_read(xPacketStream, out, len);
+			read = _comm_stream_dispatch_read(xPacketStream, out, len);
 
 			if (read < 0) goto error;
+			if (read == 0 && len > 0 && !comm_stream_wait_readable(xPacketStream, COMM_STREAM_WAIT_FOREVER)) goto error;
 
 			out += read;
 			len -= read;
@@ -135,12 +177,12 @@ COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* xPa
 		goto packet_ready;
 	} else {
 		uint32_t availableRead;
-		while (comm_stream_available_read(xPacketStream)) {
+		while (_comm_stream_dispatch_available_read(xPacketStream)) {
 			// Header
 			if (packetStream->totalRead == -1) {
 				out = packetStream->buffer;
 
-				read = comm_stream_read(xPacketStream, out, 1);
+				read = _comm_stream_dispatch_read(xPacketStream, out, 1);
 
 				if (read == 0) return NULL;
 
@@ -153,10 +195,10 @@ COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* xPa
 			len = packetStream->buffer[0] - packetStream->totalRead;
 			out = packetStream->buffer + 1 + packetStream->totalRead;
 
-			availableRead = comm_stream_available_read(xPacketStream);
+			availableRead = _comm_stream_dispatch_available_read(xPacketStream);
 
 			if (len > 0 && availableRead > 0) {
-				read = comm_stream_read(xPacketStream, out, __MIN(len, availableRead));
+				read = _comm_stream_dispatch_read(xPacketStream, out, __MIN(len, availableRead));
 
 				if (read == 0) return NULL;
 
@@ -175,6 +217,7 @@ COMM_PUBLIC uint8_t* COMM_CALL comm_packet_stream_read(comm_packet_stream_t* xPa
 
 packet_ready:
 	packetStream->totalRead = -1;
+	_COMM_TRACE2(packet_frame, xPacketStream, packetStream->buffer[0]);
 
 	if (lenOut)
 		*lenOut = packetStream->buffer[0];
@@ -185,3 +228,11 @@ error:
 	packetStream->totalRead = -1;
 	return NULL;
 }
+
+COMM_PUBLIC void COMM_CALL comm_packet_stream_set_block_write(comm_packet_stream_t* packetStream, bool blockWrite, size_t maxPending) {
+	_comm_frame_stream_set_block_write((_comm_frame_stream_t*)packetStream, blockWrite, maxPending);
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_packet_stream_pending(const comm_packet_stream_t* packetStream) {
+	return _comm_frame_stream_pending((const _comm_frame_stream_t*)packetStream);
+}
@@ -0,0 +1,849 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "_fd_stream.h"
+#include "_frame_stream.h"
+#include "_stream_dispatch.h"
+#include "_uring.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/reactor.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define __MAX_EVENTS        256
+#define __INITIAL_CAPACITY  64
+#define __URING_ENTRIES     1024
+#define __URING_IGNORE_TAG  UINT64_MAX // Completions nothing waits for (buffer returns, cancellations)
+#define __READ_BUFFER_GROUP 0
+#define __READ_BUFFER_SIZE  4096
+#define __READ_BUFFERS      64
+#define __MAX_WRITE_VEC     16
+#define __MAX_QUEUED_OUTPUT (256 * 1024) // Per stream: further writes are refused until output is sent
+
+// io_uring completions are matched against entries through the descriptor and a generation
+// number, so that completions of a removed registration are not taken for a newer one. Write
+// requests are tagged in the descriptor field.
+#define __USER_DATA(entry) (((uint64_t)(entry)->generation << 32) | (uint32_t)(entry)->fd)
+#define __WRITE_TAG        0x80000000u
+#define __FD(userData)     ((int)((uint32_t)(userData) & ~__WRITE_TAG))
+
+typedef struct __reactor    __reactor_t;
+typedef struct __entry      __entry_t;
+typedef struct __completion __completion_t;
+
+struct __entry {
+	comm_stream_t* stream;
+	comm_stream_t* fdStream; // Innermost stream
+	int            fd;
+	uint32_t       generation;
+	bool           isPacket;
+	bool           readPosted;  // io_uring read in flight
+	bool           writePosted; // io_uring write of 'iov' in flight
+	comm_reactor_on_line_t   onLine;
+	comm_reactor_on_packet_t onPacket;
+	comm_reactor_on_close_t  onClose;
+	void*      userData;
+	__entry_t* next; // Link in removed list
+
+	// io_uring only
+	__reactor_t* reactor;
+	bool         outputListed; // Linked in reactor output list
+	__entry_t*   prevOutput;
+	__entry_t*   nextOutput;
+
+	struct iovec  iov[__MAX_WRITE_VEC];
+	struct msghdr msg;
+};
+
+struct __completion {
+	uint64_t userData;
+	int32_t  result;
+	int32_t  bufferId;
+};
+
+struct __reactor {
+	comm_obj_t obj;
+
+	const comm_reactor_controller_t* controller;
+	int         epollFd;  // -1 when using io_uring
+	_comm_uring_t* ring;  // NULL when using epoll
+	uint32_t    generation;
+	__entry_t** entries;  // Indexed by file descriptor
+	int         capacity;
+	uint32_t    count;
+	__entry_t*  removed;  // Entries removed while dispatching (released after dispatching)
+	bool        dispatching;
+
+	// io_uring only
+	uint8_t*        readBuffers; // Provided to reads, __READ_BUFFER_SIZE bytes each
+	__entry_t*      outputList;  // Entries whose output was queued since their last posted write
+	__completion_t* backlog;     // Completions reaped while removing a stream, handled by next run
+	uint32_t        backlogCount;
+	uint32_t        backlogCapacity; // Two requests (read and write) per registered stream
+};
+
+static void __remove(__reactor_t* reactor, __entry_t* entry);
+
+static void __release_removed(__reactor_t* reactor) {
+	while (reactor->removed) {
+		__entry_t* next = reactor->removed->next;
+		_comm_mem_free(reactor->removed);
+		reactor->removed = next;
+	}
+}
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__reactor_t* reactor = (__reactor_t*)obj;
+
+	if (reactor->controller && reactor->controller->on_deinit)
+		reactor->controller->on_deinit(obj);
+
+	// Requests still in flight are settled before their buffers go away
+	for (int fd = 0; fd < reactor->capacity; fd++) {
+		if (reactor->entries[fd])
+			__remove(reactor, reactor->entries[fd]);
+	}
+
+	__release_removed(reactor);
+	_comm_mem_free(reactor->entries);
+
+	if (reactor->ring) {
+		_comm_uring_del(reactor->ring);
+		_comm_mem_free(reactor->readBuffers);
+
+		if (reactor->backlog)
+			_comm_mem_free(reactor->backlog);
+	} else {
+		close(reactor->epollFd);
+	}
+}
+
+static bool __reserve(__reactor_t* reactor, int fd) {
+	if (fd < reactor->capacity)
+		return true;
+
+	int capacity = reactor->capacity;
+	while (capacity <= fd)
+		capacity *= 2;
+
+	__entry_t** entries = _comm_mem_alloc(capacity * sizeof(__entry_t*));
+
+	if (!entries)
+		return false;
+
+	memcpy(entries, reactor->entries, reactor->capacity * sizeof(__entry_t*));
+	memset(entries + reactor->capacity, 0, (capacity - reactor->capacity) * sizeof(__entry_t*));
+
+	_comm_mem_free(reactor->entries);
+	reactor->entries = entries;
+	reactor->capacity = capacity;
+
+	return true;
+}
+
+static bool __reserve_backlog(__reactor_t* reactor, uint32_t capacity) {
+	if (capacity <= reactor->backlogCapacity)
+		return true;
+
+	capacity = capacity > 2 * reactor->backlogCapacity ? capacity : 2 * reactor->backlogCapacity;
+
+	__completion_t* backlog = _comm_mem_alloc(capacity * sizeof(__completion_t));
+
+	if (!backlog)
+		return false;
+
+	if (reactor->backlog) {
+		memcpy(backlog, reactor->backlog, reactor->backlogCount * sizeof(__completion_t));
+		_comm_mem_free(reactor->backlog);
+	}
+
+	reactor->backlog = backlog;
+	reactor->backlogCapacity = capacity;
+
+	return true;
+}
+
+static bool __owns(const __entry_t* entry, uint64_t userData) {
+	return (userData & ~(uint64_t)__WRITE_TAG) == __USER_DATA(entry);
+}
+
+static bool __post_read(__reactor_t* reactor, __entry_t* entry) {
+	if (!_comm_uring_read(reactor->ring, entry->fd, _comm_fd_stream_is_socket(entry->fdStream), __READ_BUFFER_GROUP, __READ_BUFFER_SIZE, __USER_DATA(entry)))
+		return false;
+
+	entry->readPosted = true;
+	return true;
+}
+
+// Posts a write of the output queued by the stream, if any
+static void __list_output(__reactor_t* reactor, __entry_t* entry) {
+	if (entry->outputListed)
+		return;
+
+	entry->outputListed = true;
+	entry->prevOutput = NULL;
+	entry->nextOutput = reactor->outputList;
+
+	if (reactor->outputList)
+		reactor->outputList->prevOutput = entry;
+
+	reactor->outputList = entry;
+}
+
+static void __unlist_output(__reactor_t* reactor, __entry_t* entry) {
+	if (!entry->outputListed)
+		return;
+
+	if (entry->prevOutput)
+		entry->prevOutput->nextOutput = entry->nextOutput;
+	else
+		reactor->outputList = entry->nextOutput;
+
+	if (entry->nextOutput)
+		entry->nextOutput->prevOutput = entry->prevOutput;
+
+	entry->outputListed = false;
+}
+
+// Called by the fd stream when its output queue stops being empty
+static void __on_output(void* context) {
+	__entry_t* entry = (__entry_t*)context;
+	__list_output(entry->reactor, entry);
+}
+
+static bool __post_write(__reactor_t* reactor, __entry_t* entry) {
+	comm_stream_vec_t vec[__MAX_WRITE_VEC];
+	uint32_t count = comm_chain_buffer_peek(_comm_fd_stream_output(entry->fdStream), vec, __MAX_WRITE_VEC);
+
+	if (count == 0)
+		return true;
+
+	for (uint32_t i = 0; i < count; i++) {
+		entry->iov[i].iov_base = vec[i].data;
+		entry->iov[i].iov_len  = vec[i].len;
+	}
+
+	memset(&entry->msg, 0, sizeof(entry->msg));
+	entry->msg.msg_iov    = entry->iov;
+	entry->msg.msg_iovlen = count;
+
+	if (!_comm_uring_write(reactor->ring, entry->fd, _comm_fd_stream_is_socket(entry->fdStream), &entry->msg, __USER_DATA(entry) | __WRITE_TAG))
+		return false;
+
+	entry->writePosted = true;
+	return true;
+}
+
+// Hands bytes received into a provided buffer over to the stream, and gives the buffer back
+static bool __receive(__reactor_t* reactor, __entry_t* entry, int32_t result, int32_t bufferId) {
+	if (bufferId < 0)
+		return true;
+
+	uint8_t* buffer = reactor->readBuffers + (size_t)bufferId * __READ_BUFFER_SIZE;
+	bool received = result <= 0 || _comm_fd_stream_receive(entry->fdStream, buffer, (uint32_t)result);
+
+	return _comm_uring_provide_buffers(reactor->ring, buffer, __READ_BUFFER_SIZE, 1, __READ_BUFFER_GROUP, (uint16_t)bufferId, __URING_IGNORE_TAG) && received;
+}
+
+// Completes a request of a stream being removed: received data is kept by the stream (and read
+// once it is detached), sent data is released from its output queue
+static void __settle_one(__reactor_t* reactor, __entry_t* entry, const __completion_t* completion) {
+	if ((uint32_t)completion->userData & __WRITE_TAG) {
+		entry->writePosted = false;
+
+		if (completion->result > 0)
+			_comm_stream_dispatch_read(_comm_fd_stream_output(entry->fdStream), NULL, (uint32_t)completion->result);
+	} else {
+		entry->readPosted = false;
+		__receive(reactor, entry, completion->result, completion->bufferId);
+	}
+}
+
+// Requests in flight reference the entry and the stream queues: they are cancelled and reaped.
+// Completions of other streams reaped meanwhile are kept for the next run.
+static void __settle(__reactor_t* reactor, __entry_t* entry) {
+	__completion_t completion;
+	uint32_t kept = 0;
+
+	for (uint32_t i = 0; i < reactor->backlogCount; i++) {
+		if (__owns(entry, reactor->backlog[i].userData)) {
+			__settle_one(reactor, entry, &reactor->backlog[i]);
+		} else {
+			reactor->backlog[kept++] = reactor->backlog[i];
+		}
+	}
+
+	reactor->backlogCount = kept;
+
+	if (entry->readPosted)
+		_comm_uring_cancel(reactor->ring, __USER_DATA(entry), __URING_IGNORE_TAG);
+
+	if (entry->writePosted)
+		_comm_uring_cancel(reactor->ring, __USER_DATA(entry) | __WRITE_TAG, __URING_IGNORE_TAG);
+
+	while ((entry->readPosted || entry->writePosted) && _comm_uring_enter(reactor->ring, COMM_STREAM_WAIT_FOREVER)) {
+		while (_comm_uring_next(reactor->ring, &completion.userData, &completion.result, &completion.bufferId)) {
+			if (completion.userData == __URING_IGNORE_TAG)
+				continue;
+
+			if (__owns(entry, completion.userData)) {
+				__settle_one(reactor, entry, &completion);
+			} else if (reactor->backlogCount < reactor->backlogCapacity) { // Room is reserved on registration
+				reactor->backlog[reactor->backlogCount++] = completion;
+			}
+		}
+	}
+}
+
+static __entry_t* __add(__reactor_t* reactor, comm_stream_t* stream) {
+	// Entries are resumed through their frame stream pending output (see __resume), and frames are
+	// read as they become available (a blocking read would stall every other stream)
+	if (!stream || !_comm_frame_stream_is(stream) || ((const _comm_frame_stream_t*)stream)->blockRead) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	comm_stream_t* fdStream = _comm_stream_wrapper_unwrap(stream);
+	int fd = comm_fd_stream_fd(fdStream);
+
+	if (fd < 0 || (fd < reactor->capacity && reactor->entries[fd])) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	if (!__reserve(reactor, fd))
+		return NULL;
+
+	__entry_t* entry = _comm_mem_alloc(sizeof(__entry_t));
+
+	if (!entry)
+		return NULL;
+
+	entry->stream = stream;
+	entry->fdStream = fdStream;
+	entry->fd = fd;
+	entry->generation = reactor->generation++;
+	entry->readPosted = false;
+	entry->writePosted = false;
+	entry->next = NULL;
+	entry->reactor = reactor;
+	entry->outputListed = false;
+	entry->prevOutput = NULL;
+	entry->nextOutput = NULL;
+
+	if (reactor->ring) {
+		// Read is submitted along with next wait for events
+		if (!__reserve_backlog(reactor, 2 * (reactor->count + 1)) || !_comm_fd_stream_attach(fdStream, __MAX_QUEUED_OUTPUT, __on_output, entry))
+			goto error;
+
+		if (!__post_read(reactor, entry)) {
+			_comm_fd_stream_detach(fdStream);
+			goto error;
+		}
+
+		if (comm_chain_buffer_size(_comm_fd_stream_output(fdStream)) > 0)
+			__list_output(reactor, entry);
+	} else {
+		struct epoll_event event = {
+			.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+			.data.fd = fd
+		};
+
+		if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+			goto error;
+	}
+
+	reactor->entries[fd] = entry;
+	reactor->count++;
+
+	return entry;
+
+error:
+	_comm_mem_free(entry);
+	errno = COMM_ERROR_IO;
+	return NULL;
+}
+
+static void __remove(__reactor_t* reactor, __entry_t* entry) {
+	int mErrno = errno;
+
+	if (reactor->ring) {
+		__settle(reactor, entry);
+		_comm_fd_stream_detach(entry->fdStream);
+		__unlist_output(reactor, entry);
+	} else {
+		// Descriptor may have been closed already (which implicitly removes it from the epoll set)
+		epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, entry->fd, NULL);
+	}
+
+	errno = mErrno;
+
+	reactor->entries[entry->fd] = NULL;
+	reactor->count--;
+
+	if (reactor->dispatching) {
+		entry->next = reactor->removed;
+		reactor->removed = entry;
+	} else {
+		_comm_mem_free(entry);
+	}
+}
+
+static void __close_entry(__reactor_t* reactor, __entry_t* entry) {
+	__remove(reactor, entry);
+
+	if (entry->onClose)
+		entry->onClose(entry->stream, entry->userData);
+}
+
+// Resumes pending output of a stream using non-blocking writes.
+static bool __resume(__entry_t* entry) {
+	int mErrno = errno;
+	bool result = _comm_frame_stream_pending((_comm_frame_stream_t*)entry->stream) == 0 || _comm_stream_dispatch_flush(entry->stream);
+
+	errno = mErrno;
+	return result;
+}
+
+// Edge-triggered readiness: the stream must be drained until its wrapped descriptor has no
+// more pending bytes, otherwise no further event would be reported for data already received.
+static int32_t __dispatch(__reactor_t* reactor, __entry_t* entry, bool hangup) {
+	int32_t frames = 0;
+	bool failed = false;
+	int mErrno = errno;
+
+	while (reactor->entries[entry->fd] == entry) {
+		errno = 0;
+
+		if (entry->isPacket) {
+			uint8_t len;
+			uint8_t* packet = comm_packet_stream_read(entry->stream, &len);
+
+			if (!packet) {
+				failed = errno != 0;
+				break;
+			}
+
+			entry->onPacket(entry->stream, packet, len, entry->userData);
+		} else {
+			char* line = comm_line_stream_read(entry->stream);
+
+			if (!line) {
+				failed = errno != 0;
+				break;
+			}
+
+			entry->onLine(entry->stream, line, entry->userData);
+		}
+
+		frames++;
+	}
+
+	errno = mErrno;
+
+	if ((hangup || failed) && reactor->entries[entry->fd] == entry)
+		__close_entry(reactor, entry);
+
+	return frames;
+}
+
+// Read buffers are provided (and the operations using them checked for) up front, so that
+// kernels lacking them fall back to epoll.
+static bool __setup_uring(__reactor_t* reactor) {
+	__completion_t completion;
+	int mErrno = errno;
+
+	reactor->ring = _comm_uring_new(__URING_ENTRIES);
+	reactor->readBuffers = reactor->ring ? _comm_mem_alloc((size_t)__READ_BUFFERS * __READ_BUFFER_SIZE) : NULL;
+
+	bool result = reactor->readBuffers
+		&& _comm_uring_provide_buffers(reactor->ring, reactor->readBuffers, __READ_BUFFER_SIZE, __READ_BUFFERS, __READ_BUFFER_GROUP, 0, 0)
+		&& _comm_uring_enter(reactor->ring, COMM_STREAM_WAIT_FOREVER)
+		&& _comm_uring_next(reactor->ring, &completion.userData, &completion.result, &completion.bufferId)
+		&& completion.result >= 0;
+
+	errno = mErrno;
+	return result;
+}
+
+COMM_PUBLIC comm_reactor_t* COMM_CALL comm_reactor_new(uint32_t backend, const comm_reactor_controller_t* controller, void* data) {
+	static comm_obj_controller_t mController = {
+		.on_deinit = __on_deinit
+	};
+
+	if (backend > COMM_REACTOR_BACKEND_IO_URING) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__reactor_t* reactor = _comm_mem_alloc(sizeof(__reactor_t));
+
+	if (!reactor)
+		goto error;
+
+	reactor->entries = _comm_mem_alloc(__INITIAL_CAPACITY * sizeof(__entry_t*));
+
+	if (!reactor->entries)
+		goto error;
+
+	reactor->ring = NULL;
+	reactor->epollFd = -1;
+	reactor->readBuffers = NULL;
+	reactor->backlog = NULL;
+	reactor->backlogCount = 0;
+	reactor->backlogCapacity = 0;
+
+	if (backend != COMM_REACTOR_BACKEND_EPOLL && !__setup_uring(reactor)) {
+		if (reactor->ring)
+			_comm_uring_del(reactor->ring);
+
+		if (reactor->readBuffers)
+			_comm_mem_free(reactor->readBuffers);
+
+		reactor->ring = NULL;
+		reactor->readBuffers = NULL;
+	}
+
+	if (!reactor->ring) {
+		if (backend == COMM_REACTOR_BACKEND_IO_URING) {
+			errno = COMM_ERROR_IO;
+			goto error;
+		}
+
+		reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+		if (reactor->epollFd < 0) {
+			errno = COMM_ERROR_IO;
+			goto error;
+		}
+	}
+
+	memset(reactor->entries, 0, __INITIAL_CAPACITY * sizeof(__entry_t*));
+	reactor->controller = controller;
+	reactor->capacity = __INITIAL_CAPACITY;
+	reactor->generation = 0;
+	reactor->count = 0;
+	reactor->removed = NULL;
+	reactor->outputList = NULL;
+	reactor->dispatching = false;
+
+	_comm_obj_init((comm_obj_t*)reactor, &mController, data);
+	return (comm_reactor_t*)reactor;
+
+error:
+	if (reactor) {
+		if (reactor->entries)
+			_comm_mem_free(reactor->entries);
+
+		_comm_mem_free(reactor);
+	}
+
+	return NULL;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_line_stream(comm_reactor_t* xReactor, comm_line_stream_t* lineStream, comm_reactor_on_line_t onLine, comm_reactor_on_close_t onClose, void* userData) {
+	if (!onLine) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	__entry_t* entry = __add((__reactor_t*)xReactor, lineStream);
+
+	if (!entry)
+		return false;
+
+	entry->isPacket = false;
+	entry->onLine = onLine;
+	entry->onPacket = NULL;
+	entry->onClose = onClose;
+	entry->userData = userData;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_packet_stream(comm_reactor_t* xReactor, comm_packet_stream_t* packetStream, comm_reactor_on_packet_t onPacket, comm_reactor_on_close_t onClose, void* userData) {
+	if (!onPacket) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	__entry_t* entry = __add((__reactor_t*)xReactor, packetStream);
+
+	if (!entry)
+		return false;
+
+	entry->isPacket = true;
+	entry->onLine = NULL;
+	entry->onPacket = onPacket;
+	entry->onClose = onClose;
+	entry->userData = userData;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_remove(comm_reactor_t* xReactor, comm_stream_t* stream) {
+	__reactor_t* reactor = (__reactor_t*)xReactor;
+	int fd = stream ? comm_fd_stream_fd(_comm_stream_wrapper_unwrap(stream)) : -1;
+
+	if (fd >= 0 && fd < reactor->capacity && reactor->entries[fd] && reactor->entries[fd]->stream == stream) {
+		__remove(reactor, reactor->entries[fd]);
+		return true;
+	}
+
+	// Wrapped descriptor may have been closed already: look the stream up
+	for (fd = 0; stream && fd < reactor->capacity; fd++) {
+		if (reactor->entries[fd] && reactor->entries[fd]->stream == stream) {
+			__remove(reactor, reactor->entries[fd]);
+			return true;
+		}
+	}
+
+	errno = COMM_ERROR_INVPARAM;
+	return false;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_backend(const comm_reactor_t* reactor) {
+	return ((const __reactor_t*)reactor)->ring ? COMM_REACTOR_BACKEND_IO_URING : COMM_REACTOR_BACKEND_EPOLL;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_count(const comm_reactor_t* reactor) {
+	return ((const __reactor_t*)reactor)->count;
+}
+
+static int32_t __run_epoll(__reactor_t* reactor, uint32_t timeoutMs) {
+	struct epoll_event events[__MAX_EVENTS];
+	int32_t frames = 0;
+	int mErrno = errno;
+
+	int count = epoll_wait(reactor->epollFd, events, __MAX_EVENTS, timeoutMs == COMM_STREAM_WAIT_FOREVER ? -1 : (int)(timeoutMs > INT32_MAX ? INT32_MAX : timeoutMs));
+
+	if (count < 0) {
+		if (errno == EINTR) {
+			errno = mErrno;
+			return 0;
+		}
+
+		errno = COMM_ERROR_IO;
+		return -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		int fd = events[i].data.fd;
+
+		// Entry may have been removed by a callback of a previous event
+		if (fd >= reactor->capacity || !reactor->entries[fd])
+			continue;
+
+		if ((events[i].events & EPOLLOUT) && !__resume(reactor->entries[fd])) {
+			__close_entry(reactor, reactor->entries[fd]);
+			continue;
+		}
+
+		if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			frames += __dispatch(reactor, reactor->entries[fd], (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0);
+	}
+
+	return frames;
+}
+
+static int32_t __on_read(__reactor_t* reactor, __entry_t* entry, int32_t result, int32_t bufferId) {
+	entry->readPosted = false;
+
+	// Out of provided buffers (-ENOBUFS): read again, buffers are given back as reads complete
+	bool received = __receive(reactor, entry, result, bufferId);
+	bool hangup = !received || (result <= 0 && result != -ENOBUFS);
+	int32_t frames = __dispatch(reactor, entry, hangup);
+
+	if (reactor->entries[entry->fd] == entry && !__post_read(reactor, entry))
+		__close_entry(reactor, entry);
+
+	return frames;
+}
+
+static void __on_written(__reactor_t* reactor, __entry_t* entry, int32_t result) {
+	entry->writePosted = false;
+
+	if (result < 0 && result != -EAGAIN && result != -EINTR) {
+		__close_entry(reactor, entry);
+		return;
+	}
+
+	if (result > 0)
+		_comm_stream_dispatch_read(_comm_fd_stream_output(entry->fdStream), NULL, (uint32_t)result);
+
+	// Room was made in the output queue
+	if (!__resume(entry)) {
+		__close_entry(reactor, entry);
+		return;
+	}
+
+	// Rest of the output (not written yet, or queued while the write was in flight)
+	if (comm_chain_buffer_size(_comm_fd_stream_output(entry->fdStream)) > 0)
+		__list_output(reactor, entry);
+}
+
+static bool __next(__reactor_t* reactor, __completion_t* completion) {
+	if (reactor->backlogCount > 0) {
+		*completion = reactor->backlog[--reactor->backlogCount];
+		return true;
+	}
+
+	return _comm_uring_next(reactor->ring, &completion->userData, &completion->result, &completion->bufferId);
+}
+
+// Reads stay posted for every registered stream, using buffers provided to the kernel, and output
+// queued since the previous run is posted in one batch (only streams in the output list are
+// visited). Everything is submitted together with the wait for completions, in a single system call.
+static int32_t __run_uring(__reactor_t* reactor, uint32_t timeoutMs) {
+	__completion_t completion;
+	int32_t frames = 0;
+	int mErrno = errno;
+
+	while (reactor->outputList) {
+		__entry_t* entry = reactor->outputList;
+
+		// Entries with a write in flight are listed again once it completes (see __on_written)
+		__unlist_output(reactor, entry);
+
+		if (!entry->writePosted && !__post_write(reactor, entry)) {
+			__list_output(reactor, entry);
+			goto error;
+		}
+	}
+
+	if (!_comm_uring_enter(reactor->ring, reactor->backlogCount ? 0 : timeoutMs))
+		goto error;
+
+	errno = mErrno;
+
+	while (__next(reactor, &completion)) {
+		int fd = __FD(completion.userData);
+
+		if (completion.userData == __URING_IGNORE_TAG)
+			continue;
+
+		__entry_t* entry = fd < reactor->capacity ? reactor->entries[fd] : NULL;
+
+		// Requests of removed streams are settled on removal, so this is not expected to happen
+		if (!entry || !__owns(entry, completion.userData)) {
+			if (completion.bufferId >= 0)
+				_comm_uring_provide_buffers(reactor->ring, reactor->readBuffers + (size_t)completion.bufferId * __READ_BUFFER_SIZE, __READ_BUFFER_SIZE, 1, __READ_BUFFER_GROUP, (uint16_t)completion.bufferId, __URING_IGNORE_TAG);
+
+			continue;
+		}
+
+		if ((uint32_t)completion.userData & __WRITE_TAG) {
+			__on_written(reactor, entry, completion.result);
+		} else {
+			frames += __on_read(reactor, entry, completion.result, completion.bufferId);
+		}
+	}
+
+	return frames;
+
+error:
+	errno = COMM_ERROR_IO;
+	return -1;
+}
+
+COMM_PUBLIC int32_t COMM_CALL comm_reactor_run_once(comm_reactor_t* xReactor, uint32_t timeoutMs) {
+	__reactor_t* reactor = (__reactor_t*)xReactor;
+	int32_t frames;
+
+	reactor->dispatching = true;
+	frames = reactor->ring ? __run_uring(reactor, timeoutMs) : __run_epoll(reactor, timeoutMs);
+	reactor->dispatching = false;
+
+	__release_removed(reactor);
+	return frames;
+}
+#else
+COMM_PUBLIC comm_reactor_t* COMM_CALL comm_reactor_new(uint32_t backend, const comm_reactor_controller_t* controller, void* data) {
+	(void)backend;
+	(void)controller;
+	(void)data;
+
+	errno = COMM_ERROR_INVPARAM;
+	return NULL;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_line_stream(comm_reactor_t* reactor, comm_line_stream_t* lineStream, comm_reactor_on_line_t onLine, comm_reactor_on_close_t onClose, void* userData) {
+	(void)reactor;
+	(void)lineStream;
+	(void)onLine;
+	(void)onClose;
+	(void)userData;
+
+	errno = COMM_ERROR_INVPARAM;
+	return false;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_add_packet_stream(comm_reactor_t* reactor, comm_packet_stream_t* packetStream, comm_reactor_on_packet_t onPacket, comm_reactor_on_close_t onClose, void* userData) {
+	(void)reactor;
+	(void)packetStream;
+	(void)onPacket;
+	(void)onClose;
+	(void)userData;
+
+	errno = COMM_ERROR_INVPARAM;
+	return false;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_reactor_remove(comm_reactor_t* reactor, comm_stream_t* stream) {
+	(void)reactor;
+	(void)stream;
+
+	errno = COMM_ERROR_INVPARAM;
+	return false;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_backend(const comm_reactor_t* reactor) {
+	(void)reactor;
+
+	return COMM_REACTOR_BACKEND_AUTO;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_reactor_count(const comm_reactor_t* reactor) {
+	(void)reactor;
+
+	return 0;
+}
+
+COMM_PUBLIC int32_t COMM_CALL comm_reactor_run_once(comm_reactor_t* reactor, uint32_t timeoutMs) {
+	(void)reactor;
+	(void)timeoutMs;
+
+	errno = COMM_ERROR_INVPARAM;
+	return -1;
+}
+#endif
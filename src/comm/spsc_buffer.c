@@ -0,0 +1,341 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_stream.h"
+#include "_error.h"
+#include "_mem.h"
+#include "_mirror.h"
+
+#include <comm/spsc_buffer.h>
+#include <string.h>
+
+#ifdef __linux__
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#include <time.h>
+
+	#define __WAIT_SUPPORTED 1
+
+	// Cursors are published sequentially consistent so that they pair with waiter flags (see __notify)
+	#define __PUBLISH_ORDER __ATOMIC_SEQ_CST
+#else
+	#define __WAIT_SUPPORTED 0
+	#define __PUBLISH_ORDER  __ATOMIC_RELEASE
+#endif
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+#define __CACHE_LINE_SIZE 64
+
+typedef struct __spsc_buffer __spsc_buffer_t;
+
+// Cursors are free-running counters (index = cursor & mask), so the buffer is empty when both
+// cursors are equal and full when they differ by capacity: no shared full/empty flag is needed.
+//
+// Each side owns a cache line (kept apart by padding) holding its own cursor and a private copy
+// of the remote cursor, which is refreshed only when the copy does not allow the requested operation.
+// Copies are written only by their owning side from read()/write(): availability queries (which
+// take a const stream) load remote cursors without touching them.
+struct __spsc_buffer {
+	comm_stream_t stream;
+
+	const comm_spsc_buffer_controller_t* controller;
+	uint8_t* storage;
+	size_t   capacity;
+	size_t   mask;
+	bool     mirrored;
+
+	uint8_t padding0[__CACHE_LINE_SIZE];
+
+	// Consumer side
+	size_t readCursor;
+	size_t cachedWriteCursor; // Mutable consumer-private copy of writeCursor
+
+	uint8_t padding1[__CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+	// Producer side
+	size_t writeCursor;
+	size_t cachedReadCursor;  // Mutable producer-private copy of readCursor
+
+	uint8_t padding2[__CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+
+	// Blocking waits (only touched when a side is waiting)
+	uint32_t dataEvent;       // Bumped by producer, waited by consumer
+	uint32_t consumerWaiting;
+	uint32_t spaceEvent;      // Bumped by consumer, waited by producer
+	uint32_t producerWaiting;
+
+	uint8_t padding3[__CACHE_LINE_SIZE - 4 * sizeof(uint32_t)];
+};
+
+#if __WAIT_SUPPORTED
+// A side going to sleep publishes its 'waiting' flag and then re-checks the cursors, while the
+// other side publishes its cursor and then checks the flag. Both stores and both loads are
+// sequentially consistent, so at least one side sees the other without a standalone fence on
+// every read/write: the notifying side pays a single load while nobody waits.
+static void __notify(uint32_t* waiting, uint32_t* event) {
+	if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+		__atomic_add_fetch(event, 1, __ATOMIC_RELEASE);
+		syscall(SYS_futex, event, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+}
+
+static uint64_t __now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool __readable(const __spsc_buffer_t* buffer) {
+	return __atomic_load_n(&buffer->writeCursor, __ATOMIC_SEQ_CST) != buffer->readCursor;
+}
+
+static bool __writable(const __spsc_buffer_t* buffer) {
+	return buffer->writeCursor - __atomic_load_n(&buffer->readCursor, __ATOMIC_SEQ_CST) < buffer->capacity;
+}
+
+static bool __wait(__spsc_buffer_t* buffer, uint32_t* waiting, uint32_t* event, bool (*ready)(const __spsc_buffer_t*), uint32_t timeoutMs) {
+	uint64_t deadline = __now_ns() + (uint64_t)timeoutMs * 1000000ull;
+	int mErrno = errno; // Timeouts and interruptions are not errors
+	bool result;
+
+	while (true) {
+		uint32_t mEvent = __atomic_load_n(event, __ATOMIC_ACQUIRE);
+
+		__atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+
+		if (ready(buffer)) {
+			result = true;
+			break;
+		}
+
+		struct timespec mTimeout;
+		struct timespec* timeout = NULL;
+
+		if (timeoutMs != COMM_STREAM_WAIT_FOREVER) {
+			uint64_t now = __now_ns();
+
+			if (now >= deadline) {
+				result = false;
+				break;
+			}
+
+			mTimeout.tv_sec  = (deadline - now) / 1000000000ull;
+			mTimeout.tv_nsec = (deadline - now) % 1000000000ull;
+			timeout = &mTimeout;
+		}
+
+		syscall(SYS_futex, event, FUTEX_WAIT_PRIVATE, mEvent, timeout, NULL, 0);
+	}
+
+	__atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+	errno = mErrno;
+	return result;
+}
+
+static bool COMM_CALL __wait_readable(comm_stream_t* stream, uint32_t timeoutMs) {
+	__spsc_buffer_t* buffer = (__spsc_buffer_t*)stream;
+	return __wait(buffer, &buffer->consumerWaiting, &buffer->dataEvent, __readable, timeoutMs);
+}
+
+static bool COMM_CALL __wait_writable(comm_stream_t* stream, uint32_t timeoutMs) {
+	__spsc_buffer_t* buffer = (__spsc_buffer_t*)stream;
+	return __wait(buffer, &buffer->producerWaiting, &buffer->spaceEvent, __writable, timeoutMs);
+}
+#endif
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__spsc_buffer_t* buffer = (__spsc_buffer_t*)obj;
+
+	if (buffer->controller && buffer->controller->on_deinit)
+		buffer->controller->on_deinit(obj);
+
+	if (buffer->mirrored) {
+		_comm_mirror_free(buffer->storage, buffer->capacity);
+	} else {
+		_comm_mem_free(buffer->storage);
+	}
+}
+
+// Consumer side: bytes available for reading, refreshing the copy of the producer cursor only
+// when it does not cover 'len' bytes.
+static size_t __readable_bytes(__spsc_buffer_t* buffer, size_t len) {
+	size_t availableRead = buffer->cachedWriteCursor - buffer->readCursor;
+
+	if (availableRead < len) {
+		buffer->cachedWriteCursor = __atomic_load_n(&buffer->writeCursor, __ATOMIC_ACQUIRE);
+		availableRead = buffer->cachedWriteCursor - buffer->readCursor;
+	}
+
+	return availableRead;
+}
+
+// Producer side: bytes available for writing, refreshing the copy of the consumer cursor only
+// when it does not cover 'len' bytes.
+static size_t __writable_bytes(__spsc_buffer_t* buffer, size_t len) {
+	size_t availableWrite = buffer->capacity - (buffer->writeCursor - buffer->cachedReadCursor);
+
+	if (availableWrite < len) {
+		buffer->cachedReadCursor = __atomic_load_n(&buffer->readCursor, __ATOMIC_ACQUIRE);
+		availableWrite = buffer->capacity - (buffer->writeCursor - buffer->cachedReadCursor);
+	}
+
+	return availableWrite;
+}
+
+static uint32_t COMM_CALL __available_read(const comm_stream_t* stream) {
+	const __spsc_buffer_t* buffer = (const __spsc_buffer_t*)stream;
+
+	return __atomic_load_n(&buffer->writeCursor, __ATOMIC_ACQUIRE) - buffer->readCursor;
+}
+
+static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
+	__spsc_buffer_t* buffer = (__spsc_buffer_t*)stream;
+
+	size_t readCursor = buffer->readCursor;
+	size_t availableRead = __readable_bytes(buffer, len);
+
+	len = __MIN(len, availableRead);
+
+	if (len == 0)
+		return 0;
+
+	if (out) {
+		size_t index = readCursor & buffer->mask;
+		size_t head  = buffer->mirrored ? len : __MIN(len, buffer->capacity - index);
+
+		memcpy(out, buffer->storage + index, head);
+
+		if (len > head)
+			memcpy((uint8_t*)out + head, buffer->storage, len - head);
+	}
+
+	__atomic_store_n(&buffer->readCursor, readCursor + len, __PUBLISH_ORDER);
+
+#if __WAIT_SUPPORTED
+	__notify(&buffer->producerWaiting, &buffer->spaceEvent);
+#endif
+
+	return len;
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+	const __spsc_buffer_t* buffer = (const __spsc_buffer_t*)stream;
+
+	return buffer->capacity - (buffer->writeCursor - __atomic_load_n(&buffer->readCursor, __ATOMIC_ACQUIRE));
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	__spsc_buffer_t* buffer = (__spsc_buffer_t*)stream;
+
+	size_t writeCursor = buffer->writeCursor;
+	size_t availableWrite = __writable_bytes(buffer, len);
+
+	len = __MIN(len, availableWrite);
+
+	if (len == 0)
+		return 0;
+
+	size_t index = writeCursor & buffer->mask;
+	size_t head  = buffer->mirrored ? len : __MIN(len, buffer->capacity - index);
+
+	memcpy(buffer->storage + index, in, head);
+
+	if (len > head)
+		memcpy(buffer->storage, (const uint8_t*)in + head, len - head);
+
+	__atomic_store_n(&buffer->writeCursor, writeCursor + len, __PUBLISH_ORDER);
+
+#if __WAIT_SUPPORTED
+	__notify(&buffer->consumerWaiting, &buffer->dataEvent);
+#endif
+
+	return len;
+}
+
+static comm_spsc_buffer_t* __new(size_t capacity, bool mirror, const comm_spsc_buffer_controller_t* controller, void* data) {
+	static comm_stream_controller_t mController = {
+		.objController.on_deinit = __on_deinit,
+
+		.available_read   = __available_read,
+		.read             = __read,
+		.available_write  = __available_write,
+		.write            = __write,
+#if __WAIT_SUPPORTED
+		.wait_readable    = __wait_readable,
+		.wait_writable    = __wait_writable
+#endif
+	};
+
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__spsc_buffer_t* buffer = _comm_mem_alloc(sizeof(__spsc_buffer_t));
+
+	if (!buffer)
+		goto error;
+
+	buffer->storage  = mirror ? _comm_mirror_alloc(capacity) : NULL;
+	buffer->mirrored = buffer->storage != NULL;
+
+	if (!buffer->mirrored) {
+		buffer->storage = _comm_mem_alloc(capacity);
+
+		if (!buffer->storage)
+			goto error;
+	}
+
+	buffer->controller = controller;
+	buffer->capacity = capacity;
+	buffer->mask = capacity - 1;
+	buffer->readCursor = 0;
+	buffer->cachedWriteCursor = 0;
+	buffer->writeCursor = 0;
+	buffer->cachedReadCursor = 0;
+	buffer->dataEvent = 0;
+	buffer->consumerWaiting = 0;
+	buffer->spaceEvent = 0;
+	buffer->producerWaiting = 0;
+
+	_comm_stream_init((comm_stream_t*)buffer, &mController, data);
+	return (comm_spsc_buffer_t*)buffer;
+
+error:
+	if (buffer)
+		_comm_mem_free(buffer);
+
+	return NULL;
+}
+
+COMM_PUBLIC comm_spsc_buffer_t* COMM_CALL comm_spsc_buffer_new(size_t capacity, const comm_spsc_buffer_controller_t* controller, void* data) {
+	return __new(capacity, false, controller, data);
+}
+
+COMM_PUBLIC comm_spsc_buffer_t* COMM_CALL comm_spsc_buffer_new_mirrored(size_t capacity, const comm_spsc_buffer_controller_t* controller, void* data) {
+	return __new(capacity, true, controller, data);
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_spsc_buffer_capacity(const comm_spsc_buffer_t* buffer) {
+	return ((const __spsc_buffer_t*)buffer)->capacity;
+}
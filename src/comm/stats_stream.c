@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_stream_wrapper.h"
+#include "_stream_dispatch.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/stats_stream.h>
+#include <string.h>
+
+typedef struct __stats_stream __stats_stream_t;
+
+struct __stats_stream {
+	_comm_stream_wrapper_t wrapper;
+
+	comm_stats_stream_dir_t read;
+	comm_stats_stream_dir_t write;
+	uint64_t flushes;
+	uint64_t flushErrors;
+};
+
+#define __READ_TARGET(stream)  (((_comm_stream_wrapper_t*)(stream))->readTarget)
+#define __WRITE_TARGET(stream) (((_comm_stream_wrapper_t*)(stream))->writeTarget)
+
+// Each counter has a single writer, so a relaxed load/store pair (instead of an atomic
+// read-modify-write) is enough to keep concurrent snapshots tear-free.
+#define __ADD(counter, value) __atomic_store_n(&(counter), __atomic_load_n(&(counter), __ATOMIC_RELAXED) + (value), __ATOMIC_RELAXED)
+
+static uint32_t __bucket(uint64_t len) {
+	if (len == 0)
+		return 0;
+
+	return len >> 32 ? COMM_STATS_STREAM_BUCKETS - 1 : 32 - (uint32_t)__builtin_clz((uint32_t)len);
+}
+
+static void __record(comm_stats_stream_dir_t* dir, uint64_t requested, int32_t result) {
+	__ADD(dir->calls, 1);
+	__ADD(dir->sizes[__bucket(requested)], 1);
+
+	if (result < 0) {
+		__ADD(dir->errors, 1);
+	} else if (result == 0) {
+		if (requested)
+			__ADD(dir->zeroReturns, 1);
+	} else {
+		__ADD(dir->bytes, (uint64_t)result);
+
+		if ((uint64_t)result < requested)
+			__ADD(dir->shortReturns, 1);
+	}
+}
+
+static uint64_t __total(const comm_stream_vec_t* vec, uint32_t count) {
+	uint64_t total = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+		total += vec[i].len;
+
+	return total;
+}
+
+static int32_t COMM_CALL __read(comm_stream_t* stream, void* out, uint32_t len) {
+	int32_t result = _comm_stream_dispatch_read(__READ_TARGET(stream), out, len);
+
+	__record(&((__stats_stream_t*)stream)->read, len, result);
+	return result;
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	int32_t result = _comm_stream_dispatch_write(__WRITE_TARGET(stream), in, len);
+
+	__record(&((__stats_stream_t*)stream)->write, len, result);
+	return result;
+}
+
+static int32_t COMM_CALL __readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	int32_t result = _comm_stream_dispatch_readv(__READ_TARGET(stream), vec, count);
+
+	__record(&((__stats_stream_t*)stream)->read, __total(vec, count), result);
+	return result;
+}
+
+static int32_t COMM_CALL __writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	int32_t result = _comm_stream_dispatch_writev(__WRITE_TARGET(stream), vec, count);
+
+	__record(&((__stats_stream_t*)stream)->write, __total(vec, count), result);
+	return result;
+}
+
+static bool COMM_CALL __flush(comm_stream_t* xStream) {
+	__stats_stream_t* stream = (__stats_stream_t*)xStream;
+	bool result = _comm_stream_dispatch_flush(__WRITE_TARGET(stream));
+
+	__ADD(stream->flushes, 1);
+
+	if (!result)
+		__ADD(stream->flushErrors, 1);
+
+	return result;
+}
+
+static const comm_stream_controller_t __streamController = {
+	.objController.on_deinit = _comm_stream_wrapper_on_deinit,
+
+	.available_read  = _comm_stream_wrapper_available_read,
+	.read            = __read,
+	.available_write = _comm_stream_wrapper_available_write,
+	.write           = __write,
+	.flush           = __flush,
+	.close           = _comm_stream_wrapper_close,
+	.readv           = __readv,
+	.writev          = __writev,
+	.wait_readable   = _comm_stream_wrapper_wait_readable,
+	.wait_writable   = _comm_stream_wrapper_wait_writable
+};
+
+COMM_PUBLIC comm_stats_stream_t* COMM_CALL comm_stats_stream_new(comm_stream_t* wrapped, const comm_stats_stream_controller_t* controller, void* data) {
+	if (!wrapped) {
+		errno = COMM_ERROR_INVPARAM;
+		return NULL;
+	}
+
+	__stats_stream_t* stream = _comm_mem_alloc(sizeof(__stats_stream_t));
+
+	if (!stream)
+		return NULL;
+
+	memset(&stream->read, 0, sizeof(stream->read));
+	memset(&stream->write, 0, sizeof(stream->write));
+	stream->flushes = 0;
+	stream->flushErrors = 0;
+
+	_comm_stream_wrapper_init_with((_comm_stream_wrapper_t*)stream, wrapped, &__streamController, controller, data);
+	return (comm_stats_stream_t*)stream;
+}
+
+static void __copy_dir(comm_stats_stream_dir_t* dst, const comm_stats_stream_dir_t* src) {
+	dst->calls = __atomic_load_n(&src->calls, __ATOMIC_RELAXED);
+	dst->bytes = __atomic_load_n(&src->bytes, __ATOMIC_RELAXED);
+	dst->zeroReturns = __atomic_load_n(&src->zeroReturns, __ATOMIC_RELAXED);
+	dst->shortReturns = __atomic_load_n(&src->shortReturns, __ATOMIC_RELAXED);
+	dst->errors = __atomic_load_n(&src->errors, __ATOMIC_RELAXED);
+
+	for (uint32_t i = 0; i < COMM_STATS_STREAM_BUCKETS; i++)
+		dst->sizes[i] = __atomic_load_n(&src->sizes[i], __ATOMIC_RELAXED);
+}
+
+COMM_PUBLIC void COMM_CALL comm_stats_stream_snapshot(const comm_stats_stream_t* xStream, comm_stats_stream_snapshot_t* snapshot) {
+	const __stats_stream_t* stream = (const __stats_stream_t*)xStream;
+
+	__copy_dir(&snapshot->read, &stream->read);
+	__copy_dir(&snapshot->write, &stream->write);
+	snapshot->flushes = __atomic_load_n(&stream->flushes, __ATOMIC_RELAXED);
+	snapshot->flushErrors = __atomic_load_n(&stream->flushErrors, __ATOMIC_RELAXED);
+}
+
+COMM_PUBLIC void COMM_CALL comm_stats_stream_reset(comm_stats_stream_t* xStream) {
+	__stats_stream_t* stream = (__stats_stream_t*)xStream;
+
+	memset(&stream->read, 0, sizeof(stream->read));
+	memset(&stream->write, 0, sizeof(stream->write));
+	stream->flushes = 0;
+	stream->flushErrors = 0;
+}
@@ -19,9 +19,9 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
-#include "_stream.h"
+#include "_stream_dispatch.h"
 #include "_mem.h"
-#include "_error.h"
+#include "_trace.h"
 
 COMM_PUBLIC comm_stream_t* COMM_CALL comm_stream_new(const comm_stream_controller_t* controller, void* data) {
 	comm_stream_t* stream = _comm_mem_alloc(sizeof(comm_stream_t));
@@ -39,65 +39,116 @@ error:
 }
 
 COMM_PUBLIC uint32_t COMM_CALL comm_stream_available_read(const comm_stream_t* stream) {
-	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
-	if (controller && controller->available_read) {
-		return controller->available_read(stream);
-	}
-
-	return 0;
+	return _comm_stream_dispatch_available_read(stream);
 }
 
 COMM_PUBLIC int32_t COMM_CALL comm_stream_read(comm_stream_t* stream, void* out, uint32_t len) {
+	_COMM_TRACE2(stream_read_entry, stream, len);
+
+	int32_t read = _comm_stream_dispatch_read(stream, out, len);
+
+	_COMM_TRACE2(stream_read_return, stream, read);
+	return read;
+}
+
+COMM_PUBLIC uint32_t COMM_CALL comm_stream_available_write(const comm_stream_t* stream) {
+	return _comm_stream_dispatch_available_write(stream);
+}
+
+COMM_PUBLIC int32_t COMM_CALL comm_stream_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	_COMM_TRACE2(stream_write_entry, stream, len);
+
+	int32_t written = _comm_stream_dispatch_write(stream, in, len);
+
+	_COMM_TRACE2(stream_write_return, stream, written);
+	return written;
+}
+
+COMM_PUBLIC int32_t COMM_CALL comm_stream_readv(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
 	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
 
-	if (controller && controller->read) {
-		int32_t read = controller->read(stream, out, len);
+	if (controller && controller->readv) {
+		int32_t read = controller->readv(stream, vec, count);
 		if (read < 0) {
 			_COMM_ERROR_SET(COMM_ERROR_IO);
 		}
 		return read;
 	}
 
-	return 0;
-}
+	int32_t total = 0;
 
-COMM_PUBLIC uint32_t COMM_CALL comm_stream_available_write(const comm_stream_t* stream) {
-	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t read = _comm_stream_dispatch_read(stream, vec[i].data, vec[i].len);
+
+		if (read < 0)
+			return total ? total : read;
 
-	if (controller && controller->available_write) {
-		return controller->available_write(stream);
+		total += read;
+
+		if ((uint32_t)read < vec[i].len)
+			break;
 	}
 
-	return 0;
+	return total;
 }
 
-COMM_PUBLIC int32_t COMM_CALL comm_stream_write(comm_stream_t* stream, const void* in, uint32_t len) {
+COMM_PUBLIC int32_t COMM_CALL comm_stream_writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
 	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
 
-	if (controller && controller->write) {
-		int32_t written = controller->write(stream, in, len);
+	if (controller && controller->writev) {
+		int32_t written = controller->writev(stream, vec, count);
 		if (written < 0) {
 			_COMM_ERROR_SET(COMM_ERROR_IO);
 		}
 		return written;
 	}
 
-	return 0;
+	int32_t total = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t written = _comm_stream_dispatch_write(stream, vec[i].data, vec[i].len);
+
+		if (written < 0)
+			return total ? total : written;
+
+		total += written;
+
+		if ((uint32_t)written < vec[i].len)
+			break;
+	}
+
+	return total;
 }
 
-COMM_PUBLIC bool COMM_CALL comm_stream_flush(comm_stream_t* stream) {
+COMM_PUBLIC bool COMM_CALL comm_stream_wait_readable(comm_stream_t* stream, uint32_t timeoutMs) {
 	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
 
-	if (controller && controller->flush) {
-		if (!controller->flush(stream)) {
-			_COMM_ERROR_SET(COMM_ERROR_IO);
-			return false;
-		}
+	if (controller && controller->wait_readable) {
+		return controller->wait_readable(stream, timeoutMs);
 	}
 
 	return true;
 }
 
+COMM_PUBLIC bool COMM_CALL comm_stream_wait_writable(comm_stream_t* stream, uint32_t timeoutMs) {
+	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
+
+	if (controller && controller->wait_writable) {
+		return controller->wait_writable(stream, timeoutMs);
+	}
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_stream_flush(comm_stream_t* stream) {
+	_COMM_TRACE1(stream_flush_entry, stream);
+
+	bool result = _comm_stream_dispatch_flush(stream);
+
+	_COMM_TRACE2(stream_flush_return, stream, result);
+	return result;
+}
+
 COMM_PUBLIC bool COMM_CALL comm_stream_close(comm_stream_t* stream) {
 	const comm_stream_controller_t* controller = (const comm_stream_controller_t*)stream->controller;
 
@@ -0,0 +1,343 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "_buffer.h"
+#include "_error.h"
+#include "_fd_stream.h"
+#include "_stream_wrapper.h"
+
+#define __BOUNCE_LEN 4096
+
+#define __MIN(a,b) ((a) <= (b) ? (a) : (b))
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#define __CHUNK_LEN (1u << 30)
+
+typedef enum {
+	__KERNEL_COPY_FILE_RANGE,
+	__KERNEL_SENDFILE,
+	__KERNEL_SPLICE,
+	__KERNEL_SPLICE_PIPE // Through an intermediate pipe
+} __kernel_method_t;
+
+// Errors telling the method does not apply to given descriptors
+static bool __unsupported(int error) {
+	return error == EINVAL || error == ENOSYS || error == EXDEV || error == EOPNOTSUPP || error == EBADF || error == ESPIPE;
+}
+
+static ssize_t __kernel_move(__kernel_method_t method, int srcFd, int dstFd, size_t len) {
+	ssize_t result;
+
+	do {
+		switch (method) {
+		case __KERNEL_COPY_FILE_RANGE:
+			result = copy_file_range(srcFd, NULL, dstFd, NULL, len, 0);
+			break;
+
+		case __KERNEL_SENDFILE:
+			result = sendfile(dstFd, srcFd, NULL, len);
+			break;
+
+		default:
+			result = splice(srcFd, NULL, dstFd, NULL, len, SPLICE_F_MOVE);
+			break;
+		}
+	} while (result < 0 && errno == EINTR);
+
+	return result;
+}
+
+// Moves everything held by the intermediate pipe into destination
+// @return Number of bytes moved (less than 'len' on error).
+static size_t __drain_pipe(int pipeFd, comm_stream_t* dst, int dstFd, size_t len) {
+	size_t drained = 0;
+
+	while (drained < len) {
+		ssize_t moved = __kernel_move(__KERNEL_SPLICE, pipeFd, dstFd, len - drained);
+
+		if (moved < 0) {
+			if (errno != EAGAIN || !comm_stream_wait_writable(dst, COMM_STREAM_WAIT_FOREVER))
+				break;
+
+			continue;
+		}
+
+		drained += (size_t)moved;
+	}
+
+	return drained;
+}
+
+// @return Number of moved bytes, -1 on error, or -2 if descriptors are not supported.
+static int64_t __copy_kernel(comm_stream_t* src, int srcFd, comm_stream_t* dst, int dstFd, uint64_t maxBytes) {
+	struct stat srcStat, dstStat;
+	__kernel_method_t method;
+	int pipeFds[2] = { -1, -1 };
+	int64_t total = 0;
+	int mErrno = errno;
+
+	if (fstat(srcFd, &srcStat) != 0 || fstat(dstFd, &dstStat) != 0) {
+		errno = mErrno;
+		return -2;
+	}
+
+	if (S_ISREG(srcStat.st_mode)) {
+		method = S_ISREG(dstStat.st_mode) ? __KERNEL_COPY_FILE_RANGE : __KERNEL_SENDFILE;
+	} else if (S_ISFIFO(srcStat.st_mode) || S_ISFIFO(dstStat.st_mode)) {
+		method = __KERNEL_SPLICE;
+	} else {
+		if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+			errno = mErrno;
+			return -2;
+		}
+
+		method = __KERNEL_SPLICE_PIPE;
+	}
+
+	while ((uint64_t)total < maxBytes) {
+		uint32_t available = comm_stream_available_read(src);
+
+		if (available == 0)
+			break;
+
+		size_t len = (size_t)__MIN(__MIN(maxBytes - (uint64_t)total, available), __CHUNK_LEN);
+		ssize_t moved = __kernel_move(method, srcFd, method == __KERNEL_SPLICE_PIPE ? pipeFds[1] : dstFd, len);
+
+		if (moved < 0) {
+			if (errno == EAGAIN && method != __KERNEL_SPLICE_PIPE && comm_stream_wait_writable(dst, COMM_STREAM_WAIT_FOREVER))
+				continue;
+
+			if (errno == EAGAIN) {
+				errno = mErrno;
+				break;
+			}
+
+			if (total == 0 && __unsupported(errno)) {
+				errno = mErrno;
+				total = -2;
+			} else {
+				total = total ? total : -1;
+			}
+
+			break;
+		}
+
+		if (moved == 0)
+			break; // End of file
+
+		if (method == __KERNEL_SPLICE_PIPE) {
+			size_t drained = __drain_pipe(pipeFds[0], dst, dstFd, (size_t)moved);
+
+			// Bytes left in the pipe are lost: report what actually reached destination
+			if (drained < (size_t)moved) {
+				total += (int64_t)drained;
+				total = total ? total : -1;
+				break;
+			}
+		}
+
+		total += moved;
+	}
+
+	if (pipeFds[0] >= 0) {
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+	}
+
+	return total;
+}
+#endif
+
+// Source is a comm_buffer: stored data is written directly from buffer storage
+static int64_t __copy_from_buffer(comm_buffer_t* src, comm_stream_t* dst, uint64_t maxBytes) {
+	comm_buffer_span_t spans[2];
+	int64_t total = 0;
+
+	while ((uint64_t)total < maxBytes) {
+		uint64_t len = __MIN(maxBytes - (uint64_t)total, INT32_MAX);
+
+		if (comm_buffer_read_peek(src, spans) == 0)
+			break;
+
+		comm_stream_vec_t vec[2];
+		uint32_t count = 0;
+
+		for (int i = 0; i < 2 && len > 0 && spans[i].len > 0; i++) {
+			vec[i].data = spans[i].data;
+			vec[i].len  = (uint32_t)__MIN(spans[i].len, len);
+			len -= vec[i].len;
+			count++;
+		}
+
+		int32_t written = comm_stream_writev(dst, vec, count);
+
+		if (written < 0)
+			return total ? total : -1;
+
+		if (written == 0) {
+			if (!_comm_stream_wrapper_can_wait_writable(dst)) {
+				errno = COMM_ERROR_AGAIN;
+				return total;
+			}
+
+			if (!comm_stream_wait_writable(dst, COMM_STREAM_WAIT_FOREVER))
+				return total ? total : -1;
+
+			continue;
+		}
+
+		comm_buffer_read_release(src, (size_t)written);
+		total += written;
+	}
+
+	return total;
+}
+
+// Destination is a comm_buffer: data is read directly into buffer storage
+static int64_t __copy_to_buffer(comm_stream_t* src, comm_buffer_t* dst, uint64_t maxBytes) {
+	comm_buffer_span_t spans[2];
+	int64_t total = 0;
+
+	while ((uint64_t)total < maxBytes) {
+		uint64_t len = __MIN(__MIN(maxBytes - (uint64_t)total, INT32_MAX), comm_stream_available_read(src));
+
+		if (len == 0)
+			break;
+
+		if (comm_buffer_write_acquire(dst, spans) == 0) {
+			errno = COMM_ERROR_AGAIN;
+			break;
+		}
+
+		comm_stream_vec_t vec[2];
+		uint32_t count = 0;
+
+		for (int i = 0; i < 2 && len > 0 && spans[i].len > 0; i++) {
+			vec[i].data = spans[i].data;
+			vec[i].len  = (uint32_t)__MIN(spans[i].len, len);
+			len -= vec[i].len;
+			count++;
+		}
+
+		int32_t read = comm_stream_readv(src, vec, count);
+
+		if (read < 0)
+			return total ? total : -1;
+
+		if (read == 0)
+			break;
+
+		comm_buffer_write_commit(dst, (size_t)read);
+		total += read;
+	}
+
+	return total;
+}
+
+static int64_t __copy_generic(comm_stream_t* src, comm_stream_t* dst, uint64_t maxBytes) {
+	uint8_t bounce[__BOUNCE_LEN];
+	int64_t total = 0;
+	bool canWait = _comm_stream_wrapper_can_wait_writable(dst);
+
+	while ((uint64_t)total < maxBytes) {
+		uint32_t len = (uint32_t)__MIN(__MIN(maxBytes - (uint64_t)total, sizeof(bounce)), comm_stream_available_read(src));
+
+		if (len == 0)
+			break;
+
+		// Destinations which cannot be waited for only get what they can take right away
+		if (!canWait) {
+			len = __MIN(len, comm_stream_available_write(dst));
+
+			if (len == 0) {
+				errno = COMM_ERROR_AGAIN;
+				break;
+			}
+		}
+
+		int32_t read = comm_stream_read(src, bounce, len);
+
+		if (read < 0)
+			return total ? total : -1;
+
+		if (read == 0)
+			break;
+
+		// Data already taken from source must reach destination
+		for (int32_t offset = 0; offset < read;) {
+			int32_t written = comm_stream_write(dst, bounce + offset, (uint32_t)(read - offset));
+
+			// Remaining bytes are lost: report what actually reached destination
+			if (written == 0 && !canWait) {
+				errno = COMM_ERROR_AGAIN;
+				return total + offset;
+			}
+
+			if (written < 0 || (written == 0 && !comm_stream_wait_writable(dst, COMM_STREAM_WAIT_FOREVER))) {
+				total += offset;
+				return total ? total : -1;
+			}
+
+			offset += written;
+		}
+
+		total += read;
+	}
+
+	return total;
+}
+
+COMM_PUBLIC int64_t COMM_CALL comm_stream_copy(comm_stream_t* src, comm_stream_t* dst, uint64_t maxBytes) {
+	if (!src || !dst || src == dst) {
+		errno = COMM_ERROR_INVPARAM;
+		return -1;
+	}
+
+#ifdef __linux__
+	int srcFd = comm_fd_stream_fd(src);
+	int dstFd = comm_fd_stream_fd(dst);
+
+	// Streams with I/O queued by a reactor are not accessed through their descriptors
+	if (srcFd >= 0 && dstFd >= 0 && _comm_fd_stream_is_direct(src) && _comm_fd_stream_is_direct(dst)) {
+		int64_t result = __copy_kernel(src, srcFd, dst, dstFd, maxBytes);
+
+		if (result != -2)
+			return result;
+	}
+#endif
+
+	if (_comm_buffer_is(src))
+		return __copy_from_buffer(src, dst, maxBytes);
+
+	if (_comm_buffer_is(dst))
+		return __copy_to_buffer(src, dst, maxBytes);
+
+	return __copy_generic(src, dst, maxBytes);
+}
@@ -0,0 +1,363 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "_stream.h"
+#include "_stream_dispatch.h"
+#include "_error.h"
+#include "_mem.h"
+
+#include <comm/tee_stream.h>
+#include <comm/chain_buffer.h>
+#include <string.h>
+
+#define __BACKLOG_CHUNK_SIZE 4096
+#define __PEEK_REGIONS       8
+
+typedef struct __tee_stream __tee_stream_t;
+typedef struct __sink       __sink_t;
+
+struct __sink {
+	comm_stream_t*       stream;
+	uint32_t             policy;
+	size_t               maxBacklog;
+	comm_chain_buffer_t* backlog; // Allocated on demand (never used by blocking sinks)
+	uint64_t             dropped;
+	bool                 failed;
+};
+
+struct __tee_stream {
+	comm_stream_t stream;
+
+	const comm_tee_stream_controller_t* controller;
+	__sink_t* sinks;
+	uint32_t  count;
+	uint32_t  capacity;
+};
+
+static void COMM_CALL __on_deinit(comm_obj_t* obj) {
+	__tee_stream_t* tee = (__tee_stream_t*)obj;
+
+	if (tee->controller && tee->controller->on_deinit)
+		tee->controller->on_deinit(obj);
+
+	for (uint32_t i = 0; i < tee->count; i++) {
+		if (tee->sinks[i].backlog)
+			comm_obj_del(tee->sinks[i].backlog);
+	}
+
+	if (tee->sinks)
+		_comm_mem_free(tee->sinks);
+}
+
+static __sink_t* __find(const __tee_stream_t* tee, const comm_stream_t* sink) {
+	for (uint32_t i = 0; i < tee->count; i++) {
+		if (tee->sinks[i].stream == sink)
+			return &tee->sinks[i];
+	}
+
+	errno = COMM_ERROR_INVPARAM;
+	return NULL;
+}
+
+static size_t __backlog_size(const __sink_t* sink) {
+	return sink->backlog ? comm_chain_buffer_size(sink->backlog) : 0;
+}
+
+// Writes backlog into sink (without waiting) straight from backlog chunks
+static bool __drain_backlog(__sink_t* sink) {
+	comm_stream_vec_t vec[__PEEK_REGIONS];
+	uint32_t count;
+
+	while (sink->backlog && (count = comm_chain_buffer_peek(sink->backlog, vec, __PEEK_REGIONS)) > 0) {
+		int32_t written = _comm_stream_dispatch_writev(sink->stream, vec, count);
+
+		if (written < 0)
+			return false;
+
+		if (written == 0)
+			break;
+
+		_comm_stream_dispatch_read(sink->backlog, NULL, (uint32_t)written);
+	}
+
+	return true;
+}
+
+// Appends given regions (skipping first 'skip' bytes) into sink backlog
+static bool __append_backlog(__sink_t* sink, const comm_stream_vec_t* vec, uint32_t count, uint32_t skip) {
+	if (!sink->backlog) {
+		sink->backlog = comm_chain_buffer_new(__BACKLOG_CHUNK_SIZE, 0, NULL, NULL);
+
+		if (!sink->backlog)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (skip >= vec[i].len) {
+			skip -= vec[i].len;
+			continue;
+		}
+
+		uint32_t len = vec[i].len - skip;
+
+		if (_comm_stream_dispatch_write(sink->backlog, (const uint8_t*)vec[i].data + skip, len) != (int32_t)len)
+			return false;
+
+		skip = 0;
+	}
+
+	return true;
+}
+
+// Writes given regions (skipping first 'skip' bytes) into sink, waiting for it as needed
+static bool __write_blocking(__sink_t* sink, const comm_stream_vec_t* vec, uint32_t count, uint32_t skip) {
+	for (uint32_t i = 0; i < count; i++) {
+		const uint8_t* data = vec[i].data;
+
+		while (skip < vec[i].len) {
+			int32_t written = _comm_stream_dispatch_write(sink->stream, data + skip, vec[i].len - skip);
+
+			if (written < 0 || (written == 0 && !comm_stream_wait_writable(sink->stream, COMM_STREAM_WAIT_FOREVER)))
+				return false;
+
+			skip += (uint32_t)written;
+		}
+
+		skip -= vec[i].len;
+	}
+
+	return true;
+}
+
+static void __fail(__sink_t* sink, uint32_t lost) {
+	sink->failed = true;
+	sink->dropped += lost + __backlog_size(sink);
+
+	if (sink->backlog)
+		comm_chain_buffer_clear(sink->backlog);
+}
+
+// @return false if a blocking sink failed (its data is then counted as dropped).
+static bool __deliver(__sink_t* sink, const comm_stream_vec_t* vec, uint32_t count, uint32_t total) {
+	if (sink->failed) {
+		sink->dropped += total;
+		return true;
+	}
+
+	if (sink->policy == COMM_TEE_STREAM_BLOCK) {
+		int32_t written = _comm_stream_dispatch_writev(sink->stream, vec, count);
+
+		if (written < 0 || !__write_blocking(sink, vec, count, (uint32_t)written)) {
+			__fail(sink, total);
+			return false;
+		}
+
+		return true;
+	}
+
+	if (!__drain_backlog(sink)) {
+		__fail(sink, total);
+		return true;
+	}
+
+	// Backlog must be written first: new data can only be queued behind it
+	if (__backlog_size(sink) > 0) {
+		if (sink->policy == COMM_TEE_STREAM_BUFFER && (!sink->maxBacklog || __backlog_size(sink) + total <= sink->maxBacklog)) {
+			if (!__append_backlog(sink, vec, count, 0))
+				__fail(sink, total);
+		} else {
+			sink->dropped += total;
+		}
+
+		return true;
+	}
+
+	if (sink->policy == COMM_TEE_STREAM_DROP && _comm_stream_dispatch_available_write(sink->stream) < total) {
+		sink->dropped += total;
+		return true;
+	}
+
+	int32_t written = _comm_stream_dispatch_writev(sink->stream, vec, count);
+
+	if (written < 0) {
+		__fail(sink, total);
+	} else if ((uint32_t)written < total) {
+		// Remainder of a partially accepted write is always kept, so that the sink never sees a
+		// truncated write (for dropping sinks it is only as large as one write)
+		if (!__append_backlog(sink, vec, count, (uint32_t)written))
+			__fail(sink, total - (uint32_t)written);
+	}
+
+	return true;
+}
+
+static uint32_t COMM_CALL __available_write(const comm_stream_t* stream) {
+	(void)stream;
+	return UINT32_MAX;
+}
+
+static int32_t COMM_CALL __writev(comm_stream_t* stream, const comm_stream_vec_t* vec, uint32_t count) {
+	__tee_stream_t* tee = (__tee_stream_t*)stream;
+	uint64_t total = 0;
+	bool failed = false;
+
+	for (uint32_t i = 0; i < count; i++)
+		total += vec[i].len;
+
+	if (total > INT32_MAX) {
+		errno = COMM_ERROR_INVPARAM;
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < tee->count; i++)
+		failed = !__deliver(&tee->sinks[i], vec, count, (uint32_t)total) || failed;
+
+	// Other sinks already got the data: a failed blocking sink is only reported
+	if (failed)
+		_COMM_ERROR_SET(COMM_ERROR_IO);
+
+	return (int32_t)total;
+}
+
+static int32_t COMM_CALL __write(comm_stream_t* stream, const void* in, uint32_t len) {
+	comm_stream_vec_t vec = { (void*)in, len };
+
+	return __writev(stream, &vec, 1);
+}
+
+static bool COMM_CALL __flush(comm_stream_t* stream) {
+	__tee_stream_t* tee = (__tee_stream_t*)stream;
+	bool result = true;
+
+	for (uint32_t i = 0; i < tee->count; i++) {
+		__sink_t* sink = &tee->sinks[i];
+
+		if (sink->failed)
+			continue;
+
+		if (!__drain_backlog(sink) || !_comm_stream_dispatch_flush(sink->stream)) {
+			__fail(sink, 0);
+			result = result && sink->policy != COMM_TEE_STREAM_BLOCK;
+		}
+	}
+
+	return result;
+}
+
+static bool COMM_CALL __close(comm_stream_t* stream) {
+	return __flush(stream);
+}
+
+COMM_PUBLIC comm_tee_stream_t* COMM_CALL comm_tee_stream_new(const comm_tee_stream_controller_t* controller, void* data) {
+	static comm_stream_controller_t mController = {
+		.objController.on_deinit = __on_deinit,
+
+		.available_write = __available_write,
+		.write           = __write,
+		.flush           = __flush,
+		.close           = __close,
+		.writev          = __writev
+	};
+
+	__tee_stream_t* tee = _comm_mem_alloc(sizeof(__tee_stream_t));
+
+	if (!tee)
+		return NULL;
+
+	tee->controller = controller;
+	tee->sinks = NULL;
+	tee->count = 0;
+	tee->capacity = 0;
+
+	_comm_stream_init((comm_stream_t*)tee, &mController, data);
+	return (comm_tee_stream_t*)tee;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_tee_stream_add_sink(comm_tee_stream_t* xTee, comm_stream_t* sink, uint32_t policy, size_t maxBacklog) {
+	__tee_stream_t* tee = (__tee_stream_t*)xTee;
+
+	if (!sink || sink == xTee || policy > COMM_TEE_STREAM_BUFFER) {
+		errno = COMM_ERROR_INVPARAM;
+		return false;
+	}
+
+	for (uint32_t i = 0; i < tee->count; i++) {
+		if (tee->sinks[i].stream == sink) {
+			errno = COMM_ERROR_INVPARAM;
+			return false;
+		}
+	}
+
+	if (tee->count == tee->capacity) {
+		uint32_t capacity = tee->capacity ? tee->capacity * 2 : 4;
+		__sink_t* sinks = _comm_mem_alloc(capacity * sizeof(__sink_t));
+
+		if (!sinks)
+			return false;
+
+		if (tee->sinks) {
+			memcpy(sinks, tee->sinks, tee->count * sizeof(__sink_t));
+			_comm_mem_free(tee->sinks);
+		}
+
+		tee->sinks = sinks;
+		tee->capacity = capacity;
+	}
+
+	__sink_t* entry = &tee->sinks[tee->count++];
+
+	entry->stream = sink;
+	entry->policy = policy;
+	entry->maxBacklog = maxBacklog;
+	entry->backlog = NULL;
+	entry->dropped = 0;
+	entry->failed = false;
+
+	return true;
+}
+
+COMM_PUBLIC bool COMM_CALL comm_tee_stream_remove_sink(comm_tee_stream_t* xTee, comm_stream_t* sink) {
+	__tee_stream_t* tee = (__tee_stream_t*)xTee;
+	__sink_t* entry = __find(tee, sink);
+
+	if (!entry)
+		return false;
+
+	if (entry->backlog)
+		comm_obj_del(entry->backlog);
+
+	memmove(entry, entry + 1, (tee->count - (uint32_t)(entry - tee->sinks) - 1) * sizeof(__sink_t));
+	tee->count--;
+
+	return true;
+}
+
+COMM_PUBLIC uint64_t COMM_CALL comm_tee_stream_dropped(const comm_tee_stream_t* tee, const comm_stream_t* sink) {
+	const __sink_t* entry = __find((const __tee_stream_t*)tee, sink);
+
+	return entry ? entry->dropped : 0;
+}
+
+COMM_PUBLIC size_t COMM_CALL comm_tee_stream_backlog(const comm_tee_stream_t* tee, const comm_stream_t* sink) {
+	const __sink_t* entry = __find((const __tee_stream_t*)tee, sink);
+
+	return entry ? __backlog_size(entry) : 0;
+}
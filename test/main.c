@@ -22,21 +22,41 @@ SOFTWARE.
 #include "mem.h"
 #include "assert.h"
 #include "tests/mem.h"
+#include "tests/slab.h"
 #include "tests/obj.h"
 #include "tests/stream.h"
 #include "tests/buffer.h"
+#include "tests/spsc_buffer.h"
+#include "tests/chain_buffer.h"
+#include "tests/buffered_stream.h"
+#include "tests/tee_stream.h"
+#include "tests/stats_stream.h"
+#include "tests/fd_stream.h"
+#include "tests/stream_copy.h"
 #include "tests/line_stream.h"
 #include "tests/packet_stream.h"
+#include "tests/packet_queue.h"
+#include "tests/reactor.h"
 
 #include <comm.h>
 
 int main() {
 	test_mem();
+	test_slab();
 	test_obj();
 	test_stream();
 	test_buffer();
+	test_spsc_buffer();
+	test_chain_buffer();
+	test_buffered_stream();
+	test_tee_stream();
+	test_stats_stream();
+	test_fd_stream();
+	test_stream_copy();
 	test_line_stream();
 	test_packet_stream();
+	test_packet_queue();
+	test_reactor();
 
 	ASSERT(mem_size() == 0);
 	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
@@ -169,6 +169,240 @@ static void __test_read_write() {
 	ASSERT(mem_size() == memSize);
 }
 
+static void __test_pow2_read_write() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	uint8_t storage[8];
+	comm_buffer_t* xBuffer = comm_buffer_new(0, NULL, NULL);
+	_comm_buffer_t* buffer = (_comm_buffer_t*)xBuffer;
+	ASSERT(comm_buffer_set_storage(xBuffer, storage, sizeof(storage), true));
+	ASSERT(buffer->mask == 7);
+
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(xBuffer));
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_write(xBuffer));
+
+	ASSERT(comm_stream_write(xBuffer, "abcdef", 6) == 6);
+	ASSERT(comm_stream_read(xBuffer, readBuf, 4) == 4);
+	ASSERT(memcmp(readBuf, "abcd", 4) == 0);
+
+	// Wrapping around the end of storage until buffer is full
+	ASSERT(comm_stream_write(xBuffer, "ghijklmn", 8) == 6);
+	ASSERT(memcmp(storage, "ijklefgh", 8) == 0);
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_read(xBuffer));
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_write(xBuffer));
+
+	ASSERT(comm_stream_read(xBuffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "efghijkl", 8) == 0);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(xBuffer));
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_write(xBuffer));
+
+	// Cursors keep running across many laps
+	for (int i = 0; i < 100; i++) {
+		ASSERT(comm_stream_write(xBuffer, "xyz", 3) == 3);
+		ASSERT(comm_stream_read(xBuffer, readBuf, 3) == 3);
+		ASSERT(memcmp(readBuf, "xyz", 3) == 0);
+	}
+
+	// Non power-of-two storage switches back to wrapping cursors
+	ASSERT(comm_buffer_set_storage(xBuffer, storage, 7, false));
+	ASSERT(buffer->mask == 0);
+	ASSERT_EQUALS(PRIu32, 7, comm_stream_available_read(xBuffer));
+
+	comm_obj_del(xBuffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_spans() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+	comm_buffer_span_t spans[2];
+
+	uint8_t storage[10];
+	comm_buffer_t* buffer = comm_buffer_new(0, NULL, NULL);
+	ASSERT(comm_buffer_set_storage(buffer, storage, sizeof(storage), true));
+
+	// Empty buffer: whole storage is writable, nothing to read
+	ASSERT(comm_buffer_read_peek(buffer, spans) == 0);
+	ASSERT(comm_buffer_write_acquire(buffer, spans) == 10);
+	ASSERT(spans[0].data == storage && spans[0].len == 10);
+	ASSERT(spans[1].len == 0);
+
+	memcpy(spans[0].data, "abcdef", 6);
+	ASSERT(comm_buffer_write_commit(buffer, 6));
+	ASSERT(comm_stream_available_read(buffer) == 6);
+
+	ASSERT(comm_buffer_read_peek(buffer, spans) == 6);
+	ASSERT(spans[0].data == storage && spans[0].len == 6);
+	ASSERT(comm_buffer_read_release(buffer, 4));
+	ASSERT(comm_stream_available_read(buffer) == 2);
+
+	// Free region wraps around the end of storage
+	ASSERT(comm_buffer_write_acquire(buffer, spans) == 8);
+	ASSERT(spans[0].data == storage + 6 && spans[0].len == 4);
+	ASSERT(spans[1].data == storage && spans[1].len == 4);
+	memcpy(spans[0].data, "ghij", 4);
+	memcpy(spans[1].data, "kl", 2);
+	ASSERT(comm_buffer_write_commit(buffer, 6));
+
+	// Readable region wraps as well
+	ASSERT(comm_buffer_read_peek(buffer, spans) == 8);
+	ASSERT(spans[0].data == storage + 4 && spans[0].len == 6);
+	ASSERT(spans[1].data == storage && spans[1].len == 2);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "efghijkl", 8) == 0);
+
+	// Commits and releases beyond available space are rejected
+	ASSERT(!comm_buffer_read_release(buffer, 1));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_buffer_write_commit(buffer, 11));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	// Full buffer
+	ASSERT(comm_buffer_write_commit(buffer, 10));
+	ASSERT(comm_buffer_write_acquire(buffer, spans) == 0);
+	ASSERT(comm_buffer_read_peek(buffer, spans) == 10);
+	ASSERT(comm_buffer_read_release(buffer, 10));
+	ASSERT(comm_stream_available_write(buffer) == 10);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_mirrored() {
+#ifdef __linux__
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+	comm_buffer_span_t spans[2];
+
+	size_t capacity = 4096;
+
+	// Mirroring is opt-in
+	comm_buffer_t* xBuffer = comm_buffer_new(capacity, NULL, NULL);
+	ASSERT(xBuffer);
+	ASSERT(!((_comm_buffer_t*)xBuffer)->mirrored);
+	comm_obj_del(xBuffer);
+
+	xBuffer = comm_buffer_new_mirrored(capacity, NULL, NULL);
+	_comm_buffer_t* buffer = (_comm_buffer_t*)xBuffer;
+	ASSERT(xBuffer);
+	ASSERT(buffer->mirrored);
+	ASSERT(comm_buffer_capacity(xBuffer) == capacity);
+
+	// Move cursors close to the end of storage
+	ASSERT(comm_buffer_write_commit(xBuffer, capacity - 4));
+	ASSERT(comm_buffer_read_release(xBuffer, capacity - 4));
+
+	// Data crossing the end of storage is still contiguous
+	ASSERT(comm_stream_write(xBuffer, "mirrored", 8) == 8);
+	ASSERT(comm_buffer_read_peek(xBuffer, spans) == 8);
+	ASSERT(spans[1].len == 0);
+	ASSERT(memcmp(spans[0].data, "mirrored", 8) == 0);
+	ASSERT(memcmp(buffer->storage, "ored", 4) == 0);
+
+	ASSERT(comm_stream_read(xBuffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "mirrored", 8) == 0);
+
+	ASSERT(comm_buffer_write_acquire(xBuffer, spans) == capacity);
+	ASSERT(spans[0].len == capacity && spans[1].len == 0);
+
+	// Non page-aligned capacity falls back to heap storage
+	ASSERT(comm_buffer_set_storage(xBuffer, NULL, 0, true));
+	ASSERT(!buffer->mirrored);
+	comm_obj_del(xBuffer);
+
+	xBuffer = comm_buffer_new_mirrored(capacity + 1, NULL, NULL);
+	ASSERT(xBuffer);
+	ASSERT(!((_comm_buffer_t*)xBuffer)->mirrored);
+	comm_obj_del(xBuffer);
+
+	ASSERT(mem_size() == memSize);
+	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
+#endif
+}
+
+static void __test_find() {
+	size_t memSize = mem_size();
+	size_t offset;
+
+	uint8_t storage[10];
+	comm_buffer_t* buffer = comm_buffer_new(0, NULL, NULL);
+	ASSERT(comm_buffer_set_storage(buffer, storage, sizeof(storage), true));
+
+	ASSERT(!comm_buffer_find(buffer, 'a', &offset));
+	ASSERT(!comm_buffer_find_pattern(buffer, "ab", 2, &offset));
+	ASSERT(!comm_buffer_find_pattern(buffer, NULL, 2, &offset));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_buffer_find_pattern(buffer, "ab", 0, &offset));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	// Make buffered data wrap around the end of storage: "lin1\r|line2"
+	ASSERT(comm_stream_write(buffer, "xxxxx", 5) == 5);
+	ASSERT(comm_stream_read(buffer, NULL, 5) == 5);
+	ASSERT(comm_stream_write(buffer, "lin1\rline2", 10) == 10);
+
+	ASSERT(comm_buffer_find(buffer, '\r', &offset));
+	ASSERT(offset == 4);
+	ASSERT(comm_buffer_find(buffer, 'n', &offset));
+	ASSERT(offset == 2);
+	ASSERT(comm_buffer_find(buffer, '2', NULL));
+	ASSERT(!comm_buffer_find(buffer, 'z', &offset));
+
+	ASSERT(comm_buffer_find_pattern(buffer, "lin", 3, &offset));
+	ASSERT(offset == 0);
+	ASSERT(comm_buffer_find_pattern(buffer, "line", 4, &offset));
+	ASSERT(offset == 5);
+	ASSERT(comm_buffer_find_pattern(buffer, "1\rli", 4, &offset)); // Crosses wrap point
+	ASSERT(offset == 3);
+	ASSERT(comm_buffer_find_pattern(buffer, "e2", 2, &offset));
+	ASSERT(offset == 8);
+	ASSERT(!comm_buffer_find_pattern(buffer, "line3", 5, &offset));
+	ASSERT(!comm_buffer_find_pattern(buffer, "2x", 2, &offset));
+
+	// Nothing was consumed
+	ASSERT(comm_stream_available_read(buffer) == 10);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_vec() {
+	size_t memSize = mem_size();
+	uint8_t a[3];
+	uint8_t b[8];
+
+	uint8_t storage[10];
+	comm_buffer_t* buffer = comm_buffer_new(0, NULL, NULL);
+	ASSERT(comm_buffer_set_storage(buffer, storage, sizeof(storage), true));
+
+	ASSERT(comm_stream_write(buffer, "xxxxxx", 6) == 6);
+	ASSERT(comm_stream_read(buffer, NULL, 6) == 6);
+
+	// Gather write wrapping around the end of storage
+	comm_stream_vec_t writeVec[3] = {
+		{ .data = "\x05",    .len = 1 },
+		{ .data = "hello", .len = 5 },
+		{ .data = "worl",  .len = 4 }
+	};
+	ASSERT(comm_stream_writev(buffer, writeVec, 3) == 10);
+	ASSERT(comm_stream_available_write(buffer) == 0);
+	ASSERT(memcmp(storage, "loworl\x05hel", 10) == 0);
+
+	// Scatter read, including a discarded region
+	comm_stream_vec_t readVec[3] = {
+		{ .data = a,    .len = sizeof(a) },
+		{ .data = NULL, .len = 2 },
+		{ .data = b,    .len = sizeof(b) }
+	};
+	ASSERT(comm_stream_readv(buffer, readVec, 3) == 10);
+	ASSERT(memcmp(a, "\x05he", 3) == 0);
+	ASSERT(memcmp(b, "oworl", 5) == 0);
+	ASSERT(comm_stream_readv(buffer, readVec, 3) == 0);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
 static void __test_data() {
 	size_t memSize = mem_size();
 
@@ -205,5 +439,10 @@ void test_buffer() {
 	__test_storage_mgmt1();
 	__test_storage_mgmt2();
 	__test_read_write();
+	__test_pow2_read_write();
+	__test_spans();
+	__test_mirrored();
+	__test_find();
+	__test_vec();
 	__test_data();
 }
@@ -0,0 +1,256 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "buffered_stream.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+static void __sleep_us(uint32_t us) {
+	struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000l };
+	nanosleep(&ts, NULL);
+}
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	ASSERT(!comm_buffered_stream_new(NULL, 16, 16, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	comm_buffer_t* buffer = comm_buffer_new(32, NULL, NULL);
+
+	bool data;
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 16, 8, NULL, &data);
+	ASSERT(stream);
+	ASSERT(&data == comm_obj_data(stream));
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(stream));
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_write(stream));
+	ASSERT_EQUALS(PRIu32, 0, comm_buffered_stream_pending(stream));
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_write() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[32];
+
+	comm_buffer_t* buffer = comm_buffer_new(32, NULL, NULL);
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 0, 8, NULL, NULL);
+
+	// Writes are coalesced until flushed
+	ASSERT(comm_stream_write(stream, "abc", 3) == 3);
+	ASSERT(comm_stream_write(stream, "de", 2) == 2);
+	ASSERT_EQUALS(PRIu32, 5, comm_buffered_stream_pending(stream));
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 0, comm_buffered_stream_pending(stream));
+	ASSERT_EQUALS(PRIu32, 5, comm_stream_available_read(buffer));
+
+	// Block is written once full
+	ASSERT(comm_stream_write(stream, "12345678", 8) == 8);
+	ASSERT_EQUALS(PRIu32, 5, comm_stream_available_read(buffer));
+	ASSERT(comm_stream_write(stream, "9", 1) == 1);
+	ASSERT_EQUALS(PRIu32, 13, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 1, comm_buffered_stream_pending(stream));
+
+	// Large writes bypass the block once it is empty
+	ASSERT(comm_stream_write(stream, "ABCDEFGHIJ", 10) == 10);
+	ASSERT_EQUALS(PRIu32, 24, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 0, comm_buffered_stream_pending(stream));
+
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 24);
+	ASSERT(memcmp(readBuf, "abcde123456789ABCDEFGHIJ", 24) == 0);
+
+	// Wrapped stream is full: output remains buffered
+	ASSERT(comm_stream_write(buffer, readBuf, 32) == 32);
+	ASSERT(comm_stream_write(stream, "xyz", 3) == 3);
+	ASSERT(comm_stream_write(stream, "0123456", 7) == 5);
+	ASSERT(comm_stream_write(stream, "56", 2) == 0);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_write(stream));
+	ASSERT(comm_stream_read(buffer, NULL, 32) == 32);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "xyz01234", 8) == 0);
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_read() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[32];
+
+	comm_buffer_t* buffer = comm_buffer_new(32, NULL, NULL);
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 8, 0, NULL, NULL);
+
+	ASSERT(comm_stream_write(buffer, "Hello world!", 12) == 12);
+	ASSERT_EQUALS(PRIu32, 12, comm_stream_available_read(stream));
+
+	// Small reads are served from the read-ahead block
+	ASSERT(comm_stream_read(stream, readBuf, 1) == 1);
+	ASSERT(readBuf[0] == 'H');
+	ASSERT_EQUALS(PRIu32, 4, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 11, comm_stream_available_read(stream));
+	ASSERT(comm_stream_read(stream, NULL, 1) == 1);
+	ASSERT(comm_stream_read(stream, readBuf, sizeof(readBuf)) == 6);
+	ASSERT(memcmp(readBuf, "llo wo", 6) == 0);
+
+	// Large reads bypass the block once it is empty
+	ASSERT(comm_stream_read(stream, readBuf, sizeof(readBuf)) == 4);
+	ASSERT(memcmp(readBuf, "rld!", 4) == 0);
+	ASSERT(comm_stream_read(stream, readBuf, sizeof(readBuf)) == 0);
+	ASSERT(comm_stream_wait_readable(stream, 0));  // comm_buffer does not support waiting
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_stacking() {
+	size_t memSize = mem_size();
+
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 16, 16, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(stream, 16, false, NULL, NULL);
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(stream, false, NULL, NULL);
+
+	ASSERT(comm_line_stream_write(lineStream, "Hello"));
+	ASSERT(comm_line_stream_write(lineStream, "World"));
+	ASSERT_EQUALS(PRIu32, 12, comm_stream_available_read(buffer));
+	ASSERT_STR_EQUALS("Hello", comm_line_stream_read(lineStream));
+	ASSERT_STR_EQUALS("World", comm_line_stream_read(lineStream));
+	ASSERT(!comm_line_stream_read(lineStream));
+
+	ASSERT(comm_packet_stream_write(packetStream, "abc", 3));
+	uint8_t len;
+	uint8_t* packet = comm_packet_stream_read(packetStream, &len);
+	ASSERT(packet && len == 3 && memcmp(packet, "abc", 3) == 0);
+
+	comm_obj_del(packetStream);
+	comm_obj_del(lineStream);
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_flush_policy() {
+	size_t memSize = mem_size();
+	uint32_t waitUs;
+
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 0, 32, NULL, NULL);
+
+	ASSERT(!comm_buffered_stream_set_flush_policy(stream, COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE + 1, 0));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	// Threshold
+	ASSERT(comm_buffered_stream_set_flush_policy(stream, COMM_BUFFERED_STREAM_FLUSH_THRESHOLD, 4));
+	ASSERT(comm_stream_write(stream, "abc", 3) == 3);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+	ASSERT(comm_buffered_stream_service(stream, &waitUs));
+	ASSERT_EQUALS(PRIu32, UINT32_MAX, waitUs);
+	ASSERT(comm_stream_write(stream, "d", 1) == 1);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 4, comm_stream_available_read(buffer));
+
+	ASSERT(comm_stream_write(stream, "e", 1) == 1);
+	ASSERT(comm_buffered_stream_sync(stream));
+	ASSERT_EQUALS(PRIu32, 5, comm_stream_available_read(buffer));
+
+	// Deadline
+	ASSERT(comm_buffered_stream_set_flush_policy(stream, COMM_BUFFERED_STREAM_FLUSH_DEADLINE, 2000));
+	ASSERT(comm_stream_write(stream, "f", 1) == 1);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT(comm_buffered_stream_service(stream, &waitUs));
+	ASSERT(waitUs > 0 && waitUs <= 2000);
+	ASSERT_EQUALS(PRIu32, 5, comm_stream_available_read(buffer));
+	__sleep_us(3000);
+	ASSERT(comm_buffered_stream_service(stream, &waitUs));
+	ASSERT_EQUALS(PRIu32, UINT32_MAX, waitUs);
+	ASSERT_EQUALS(PRIu32, 6, comm_stream_available_read(buffer));
+
+	// Adaptive: idle link flushes right away, busy link batches
+	ASSERT(comm_buffered_stream_set_flush_policy(stream, COMM_BUFFERED_STREAM_FLUSH_ADAPTIVE, 50000));
+	ASSERT(comm_stream_write(stream, "g", 1) == 1);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 7, comm_stream_available_read(buffer));
+	ASSERT(comm_stream_write(stream, "h", 1) == 1);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT(comm_stream_write(stream, "i", 1) == 1);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 7, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 2, comm_buffered_stream_pending(stream));
+	__sleep_us(60000);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT_EQUALS(PRIu32, 9, comm_stream_available_read(buffer));
+
+	uint8_t readBuf[16];
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 9);
+	ASSERT(memcmp(readBuf, "abcdefghi", 9) == 0);
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_overdue_write() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_buffered_stream_t* stream = comm_buffered_stream_new(buffer, 0, 32, NULL, NULL);
+
+	ASSERT(comm_buffered_stream_set_flush_policy(stream, COMM_BUFFERED_STREAM_FLUSH_DEADLINE, 2000));
+	ASSERT(comm_stream_write(stream, "ab", 2) == 2);
+	ASSERT(comm_stream_flush(stream));
+	ASSERT(comm_stream_write(stream, "c", 1) == 1);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+
+	// Overdue output is transferred by the next write, without servicing the stream
+	__sleep_us(3000);
+	ASSERT(comm_stream_write(stream, "d", 1) == 1);
+	ASSERT_EQUALS(PRIu32, 3, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 1, comm_buffered_stream_pending(stream));
+
+	ASSERT(comm_buffered_stream_sync(stream));
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 4);
+	ASSERT(memcmp(readBuf, "abcd", 4) == 0);
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_buffered_stream() {
+	__test_new();
+	__test_write();
+	__test_read();
+	__test_stacking();
+	__test_flush_policy();
+	__test_overdue_write();
+}
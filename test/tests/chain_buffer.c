@@ -0,0 +1,239 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "chain_buffer.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	ASSERT(!comm_chain_buffer_new(0, 0, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	bool data;
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, &data);
+	ASSERT(buffer);
+	ASSERT(&data == comm_obj_data(buffer));
+	ASSERT(comm_chain_buffer_size(buffer) == 0);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, UINT32_MAX, comm_stream_available_write(buffer));
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_read_write() {
+	size_t memSize = mem_size();
+	size_t idleSize;
+	uint8_t readBuf[32];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, NULL);
+	ASSERT(buffer);
+	idleSize = mem_size();
+
+	// Data spanning several chunks
+	ASSERT(comm_stream_write(buffer, "Hello ", 6) == 6);
+	ASSERT(comm_stream_write(buffer, "chained world!", 14) == 14);
+	ASSERT(comm_chain_buffer_size(buffer) == 20);
+	ASSERT(mem_size() > idleSize);
+
+	ASSERT(comm_stream_read(buffer, readBuf, 5) == 5);
+	ASSERT(memcmp(readBuf, "Hello", 5) == 0);
+	ASSERT(comm_stream_read(buffer, NULL, 1) == 1); // Discard
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 14);
+	ASSERT(memcmp(readBuf, "chained world!", 14) == 0);
+	ASSERT(comm_chain_buffer_size(buffer) == 0);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 0);
+
+	// Drained buffer keeps one spare chunk at most
+	size_t drainedSize = mem_size();
+	ASSERT(drainedSize > idleSize);
+	ASSERT(comm_stream_write(buffer, "abc", 3) == 3);
+	ASSERT(mem_size() == drainedSize);
+	ASSERT(comm_stream_read(buffer, readBuf, 3) == 3);
+	ASSERT(memcmp(readBuf, "abc", 3) == 0);
+
+	// Clearing
+	ASSERT(comm_stream_write(buffer, "0123456789", 10) == 10);
+	comm_chain_buffer_clear(buffer);
+	ASSERT(comm_chain_buffer_size(buffer) == 0);
+	ASSERT(mem_size() == drainedSize);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_max_size() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[32];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 10, NULL, NULL);
+	ASSERT(buffer);
+
+	ASSERT_EQUALS(PRIu32, 10, comm_stream_available_write(buffer));
+	ASSERT(comm_stream_write(buffer, "0123456789abc", 13) == 10);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_write(buffer));
+	ASSERT(comm_stream_write(buffer, "x", 1) == 0);
+
+	ASSERT(comm_stream_read(buffer, readBuf, 4) == 4);
+	ASSERT_EQUALS(PRIu32, 4, comm_stream_available_write(buffer));
+	ASSERT(comm_stream_write(buffer, "abcdef", 6) == 4);
+
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 10);
+	ASSERT(memcmp(readBuf, "456789abcd", 10) == 0);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_peek() {
+	size_t memSize = mem_size();
+	comm_stream_vec_t vec[4];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, NULL);
+	ASSERT(comm_chain_buffer_peek(buffer, vec, 4) == 0);
+
+	ASSERT(comm_stream_write(buffer, "abcdefghij", 10) == 10);
+	ASSERT(comm_stream_read(buffer, NULL, 1) == 1);
+
+	// Regions follow chunk boundaries and peeking does not consume data
+	ASSERT(comm_chain_buffer_peek(buffer, vec, 2) == 2);
+	ASSERT(comm_chain_buffer_peek(buffer, vec, 4) == 3);
+	ASSERT(vec[0].len == 3 && memcmp(vec[0].data, "bcd", 3) == 0);
+	ASSERT(vec[1].len == 4 && memcmp(vec[1].data, "efgh", 4) == 0);
+	ASSERT(vec[2].len == 2 && memcmp(vec[2].data, "ij", 2) == 0);
+	ASSERT(comm_chain_buffer_size(buffer) == 9);
+
+	ASSERT(comm_stream_read(buffer, NULL, 9) == 9);
+	ASSERT(comm_chain_buffer_peek(buffer, vec, 4) == 0);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_max_spare() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, NULL);
+	size_t idleSize = mem_size();
+
+	ASSERT(comm_stream_write(buffer, "0123456789abcdef", 16) == 16);
+	size_t fullSize = mem_size();
+
+	// Up to 'maxSpare' drained chunks are kept, so refilling the buffer allocates nothing
+	comm_chain_buffer_set_max_spare(buffer, 4);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 16);
+	ASSERT(mem_size() == fullSize);
+	ASSERT(comm_stream_write(buffer, "0123456789abcdef", 16) == 16);
+	ASSERT(mem_size() == fullSize);
+
+	// Lowering the limit frees spare chunks beyond it
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 16);
+	comm_chain_buffer_set_max_spare(buffer, 2);
+	size_t spareSize = mem_size();
+	ASSERT(spareSize < fullSize && spareSize > idleSize);
+
+	comm_chain_buffer_set_max_spare(buffer, 0);
+	ASSERT(mem_size() == idleSize);
+	ASSERT(comm_stream_write(buffer, "abc", 3) == 3);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 3);
+	ASSERT(mem_size() == idleSize);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_reserve() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, NULL);
+	size_t idleSize = mem_size();
+
+	// Writes covered by a reservation allocate nothing
+	ASSERT(comm_stream_write(buffer, "ab", 2) == 2);
+	ASSERT(comm_chain_buffer_reserve(buffer, 10));
+	size_t reservedSize = mem_size();
+	ASSERT(comm_stream_write(buffer, "cdefghijkl", 10) == 10);
+	ASSERT(mem_size() == reservedSize);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 12);
+	ASSERT(memcmp(readBuf, "abcdefghijkl", 12) == 0);
+
+	// Unused reservations are released down to the spare limit
+	comm_chain_buffer_set_max_spare(buffer, 0);
+	ASSERT(comm_chain_buffer_reserve(buffer, 8));
+	ASSERT(mem_size() > idleSize);
+	comm_chain_buffer_clear(buffer);
+	ASSERT(mem_size() == idleSize);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_truncate() {
+	size_t memSize = mem_size();
+	char readBuf[16];
+
+	comm_chain_buffer_t* buffer = comm_chain_buffer_new(4, 0, NULL, NULL);
+
+	ASSERT(comm_stream_write(buffer, "abcdefghij", 10) == 10);
+	ASSERT(comm_stream_read(buffer, NULL, 1) == 1);
+
+	// Truncating to the current size (or more) is a no-op
+	comm_chain_buffer_truncate(buffer, 9);
+	comm_chain_buffer_truncate(buffer, 100);
+	ASSERT(comm_chain_buffer_size(buffer) == 9);
+
+	// New end at a chunk boundary, then inside a chunk
+	comm_chain_buffer_truncate(buffer, 7);
+	ASSERT(comm_chain_buffer_size(buffer) == 7);
+	comm_chain_buffer_truncate(buffer, 5);
+	ASSERT(comm_chain_buffer_size(buffer) == 5);
+
+	ASSERT(comm_stream_write(buffer, "XYZ", 3) == 3);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "bcdefXYZ", 8) == 0);
+
+	ASSERT(comm_stream_write(buffer, "abc", 3) == 3);
+	comm_chain_buffer_truncate(buffer, 0);
+	ASSERT(comm_chain_buffer_size(buffer) == 0);
+	ASSERT(comm_stream_write(buffer, "de", 2) == 2);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 2);
+	ASSERT(memcmp(readBuf, "de", 2) == 0);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_chain_buffer() {
+	__test_new();
+	__test_read_write();
+	__test_max_size();
+	__test_peek();
+	__test_max_spare();
+	__test_reserve();
+	__test_truncate();
+}
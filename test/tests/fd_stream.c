@@ -0,0 +1,159 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "fd_stream.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static void __test_new() {
+	size_t memSize = mem_size();
+	int fds[2];
+
+	ASSERT(!comm_fd_stream_new(-1, 0, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	ASSERT(pipe(fds) == 0);
+
+	bool data;
+	comm_fd_stream_t* stream = comm_fd_stream_new(fds[0], COMM_FD_STREAM_CLOSE, NULL, &data);
+	ASSERT(stream);
+	ASSERT(&data == comm_obj_data(stream));
+	ASSERT(comm_fd_stream_fd(stream) == fds[0]);
+
+	comm_buffer_t* buffer = comm_buffer_new(4, NULL, NULL);
+	ASSERT(comm_fd_stream_fd(buffer) == -1);
+	comm_obj_del(buffer);
+
+	comm_obj_del(stream);
+	ASSERT(close(fds[0]) != 0); // Already closed by the stream
+	errno = 0;
+
+	ASSERT(close(fds[1]) == 0);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_read_write() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+	int fds[2];
+
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	comm_fd_stream_t* a = comm_fd_stream_new(fds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* b = comm_fd_stream_new(fds[1], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	ASSERT(a && b);
+
+	// Nothing to read: non-blocking read transfers nothing
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(b));
+	ASSERT(comm_stream_read(b, readBuf, sizeof(readBuf)) == 0);
+	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
+	ASSERT(!comm_stream_wait_readable(b, 0));
+
+	ASSERT(comm_stream_available_write(a) > 0);
+	ASSERT(comm_stream_write(a, "Hello", 5) == 5);
+	ASSERT(comm_stream_flush(a));
+	ASSERT(comm_stream_wait_readable(b, COMM_STREAM_WAIT_FOREVER));
+	ASSERT_EQUALS(PRIu32, 5, comm_stream_available_read(b));
+
+	ASSERT(comm_stream_read(b, NULL, 1) == 1); // Discard 'H'
+	ASSERT(comm_stream_read(b, readBuf, sizeof(readBuf)) == 4);
+	ASSERT(memcmp(readBuf, "ello", 4) == 0);
+
+	// Vectored operations
+	comm_stream_vec_t out[] = { { "ab", 2 }, { "cde", 3 } };
+	ASSERT(comm_stream_writev(a, out, 2) == 5);
+
+	uint8_t first[1], second[8];
+	comm_stream_vec_t in[] = { { first, 1 }, { second, sizeof(second) } };
+	ASSERT(comm_stream_wait_readable(b, COMM_STREAM_WAIT_FOREVER));
+	ASSERT(comm_stream_readv(b, in, 0) == 0);
+	ASSERT(comm_stream_readv(b, NULL, 0) == 0);
+	ASSERT(comm_stream_readv(b, in, 2) == 5);
+	ASSERT(first[0] == 'a');
+	ASSERT(memcmp(second, "bcde", 4) == 0);
+
+	// Leading discarding region
+	comm_stream_vec_t discard[] = { { NULL, 2 }, { second, sizeof(second) } };
+	ASSERT(comm_stream_writev(a, out, 2) == 5);
+	ASSERT(comm_stream_wait_readable(b, COMM_STREAM_WAIT_FOREVER));
+	ASSERT(comm_stream_readv(b, discard, 2) == 2);
+	ASSERT(comm_stream_read(b, readBuf, sizeof(readBuf)) == 3);
+	ASSERT(memcmp(readBuf, "cde", 3) == 0);
+
+	// Fill socket buffer until writes would block
+	uint8_t chunk[1024];
+	memset(chunk, 'x', sizeof(chunk));
+	while (comm_stream_write(a, chunk, sizeof(chunk)) > 0);
+	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
+	ASSERT(!comm_stream_wait_writable(a, 0));
+
+	// End-of-file is an error
+	comm_obj_del(b);
+	while (comm_stream_read(a, readBuf, sizeof(readBuf)) == 0)
+		comm_stream_wait_readable(a, COMM_STREAM_WAIT_FOREVER);
+
+	ASSERT(comm_stream_read(a, readBuf, sizeof(readBuf)) == -1);
+	ASSERT_ERROR(COMM_ERROR_IO);
+
+	ASSERT(comm_stream_close(a));
+	ASSERT(comm_fd_stream_fd(a) == -1);
+	ASSERT(comm_stream_close(a));
+
+	comm_obj_del(a);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_line_stream() {
+	size_t memSize = mem_size();
+	int fds[2];
+
+	ASSERT(pipe(fds) == 0);
+
+	comm_fd_stream_t* writer = comm_fd_stream_new(fds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* reader = comm_fd_stream_new(fds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_line_stream_t* writerLines = comm_line_stream_new(writer, 16, false, NULL, NULL);
+	comm_line_stream_t* readerLines = comm_line_stream_new(reader, 16, true, NULL, NULL);
+	ASSERT(writerLines && readerLines);
+
+	ASSERT(comm_line_stream_write(writerLines, "Hello"));
+	ASSERT_STR_EQUALS("Hello", comm_line_stream_read(readerLines));
+
+	comm_obj_del(readerLines);
+	comm_obj_del(writerLines);
+	comm_obj_del(reader);
+	comm_obj_del(writer);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_fd_stream() {
+	__test_new();
+	__test_read_write();
+	__test_line_stream();
+}
+#else
+void test_fd_stream() {}
+#endif
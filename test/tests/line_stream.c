@@ -47,7 +47,7 @@ static void __blocking_buffer_read_test() {
 	const char* line = comm_line_stream_read(lineStream);
 	ASSERT(line);
 	ASSERT_STR_EQUALS("line1", line);
-	ASSERT(comm_stream_available_read(buffer) > 0);
+	ASSERT(comm_stream_available_read(buffer) == 0); // "line2" was read along and is kept by the line stream
 	ASSERT(errno == 0);
 
 	line = comm_line_stream_read(lineStream);
@@ -115,6 +115,52 @@ static void __non_blocking_buffer_read_test() {
 	ASSERT(mem_size() == memSize);
 }
 
+static void __chunked_read_test() {
+	size_t memSize = mem_size();
+
+	comm_buffer_t* buffer = comm_buffer_new(1024, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(buffer, 4, false, NULL, NULL);
+	const char* lines = "a\rtoo long\r\rbcde\rfg";
+	const char* line;
+
+	comm_stream_write(buffer, lines, strlen(lines));
+
+	line = comm_line_stream_read(lineStream);
+	ASSERT(line);
+	ASSERT_STR_EQUALS("a", line);
+
+	// Lines are truncated to lineMaxLen
+	line = comm_line_stream_read(lineStream);
+	ASSERT(line);
+	ASSERT_STR_EQUALS("too ", line);
+
+	line = comm_line_stream_read(lineStream);
+	ASSERT(line);
+	ASSERT_STR_EQUALS("", line);
+
+	line = comm_line_stream_read(lineStream);
+	ASSERT(line);
+	ASSERT_STR_EQUALS("bcde", line);
+
+	// Incomplete line is kept until its delimiter arrives
+	ASSERT(!comm_line_stream_read(lineStream));
+	ASSERT(errno == 0);
+	ASSERT(comm_stream_available_read(buffer) == 0);
+
+	lines = "hijklmnopq\r";
+	comm_stream_write(buffer, lines, strlen(lines));
+
+	line = comm_line_stream_read(lineStream);
+	ASSERT(line);
+	ASSERT_STR_EQUALS("fghi", line);
+
+	ASSERT(!comm_line_stream_read(lineStream));
+
+	comm_obj_del(lineStream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
 static void __write_test() {
 	size_t memSize = mem_size();
 
@@ -172,6 +218,44 @@ static void __write_test() {
 	ASSERT(mem_size() == memSize);
 }
 
+static void __non_blocking_write_test() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_buffer_t* buffer = comm_buffer_new(8, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(buffer, 16, false, NULL, NULL);
+	comm_line_stream_set_block_write(lineStream, false, 16);
+
+	ASSERT(comm_line_stream_write(lineStream, "hello"));
+	ASSERT(comm_line_stream_pending(lineStream) == 0);
+
+	// Remainder is queued
+	ASSERT(comm_line_stream_write(lineStream, "world"));
+	ASSERT(comm_line_stream_pending(lineStream) == 4);
+	ASSERT(comm_stream_available_write(lineStream) == 0);
+	ASSERT(comm_stream_write(lineStream, "x", 1) == 0);
+
+	// Lines not fitting into the pending buffer are refused as a whole
+	ASSERT(!comm_line_stream_write(lineStream, "0123456789abcdef"));
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	errno = 0;
+
+	ASSERT(comm_line_stream_write(lineStream, "abc\r"));
+	ASSERT(comm_line_stream_pending(lineStream) == 8);
+
+	// Flushing resumes pending output
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "hello\rwo", 8) == 0);
+	ASSERT(comm_stream_flush(lineStream));
+	ASSERT(comm_line_stream_pending(lineStream) == 0);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "rld\rabc\r", 8) == 0);
+
+	comm_obj_del(lineStream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
 static void __test_data() {
 	size_t memSize = mem_size();
 
@@ -194,6 +278,8 @@ void test_line_stream() {
 	__wrapping_test();
 	__blocking_buffer_read_test();
 	__non_blocking_buffer_read_test();
+	__chunked_read_test();
 	__write_test();
+	__non_blocking_write_test();
 	__test_data();
 }
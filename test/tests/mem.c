@@ -24,6 +24,7 @@ SOFTWARE.
 #include "../assert.h"
 
 #include <comm/_mem.h>
+#include <comm/mem.h>
 
 static void __test_mem() {
 	void* ptr;
@@ -43,7 +44,18 @@ static void __test_override() {
 	ASSERT(mem_size() == 0);
 }
 
+static void __test_trim() {
+	void* ptr;
+	ASSERT(ptr = _comm_mem_alloc(12));
+	_comm_mem_free(ptr);
+
+	// Nothing is cached without the slab allocator
+	comm_mem_trim();
+	ASSERT(mem_size() == 0);
+}
+
 void test_mem() {
 	__test_mem();
 	__test_override();
+	__test_trim();
 }
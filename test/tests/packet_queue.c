@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "packet_queue.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define __PRODUCERS             4
+#define __PACKETS_PER_PRODUCER  2000
+
+static void __invalid_params_test() {
+	uint8_t storage[4];
+	comm_buffer_t* buffer = comm_buffer_new(0, NULL, NULL);
+	comm_buffer_set_storage(buffer, storage, sizeof(storage), true);
+
+	ASSERT(!comm_packet_queue_new(NULL, 4, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_packet_queue_new(buffer, 0, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_packet_queue_new(buffer, 3, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	comm_obj_del(buffer);
+}
+
+static void __push_drain_test() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	uint8_t storage[12];
+	comm_buffer_t* buffer = comm_buffer_new(0, NULL, NULL);
+	ASSERT(buffer);
+	comm_buffer_set_storage(buffer, storage, sizeof(storage), true);
+
+	bool data;
+	comm_packet_queue_t* queue = comm_packet_queue_new(buffer, 2, NULL, &data);
+	ASSERT(queue);
+	ASSERT(&data == comm_obj_data(queue));
+
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+
+	ASSERT(!comm_packet_queue_push(queue, NULL, 3));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	ASSERT(comm_packet_queue_push(queue, "PACKET", 6));
+	ASSERT(comm_packet_queue_push(queue, "QUEUE", 5));
+
+	// Queue is full
+	ASSERT(!comm_packet_queue_push(queue, NULL, 0));
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+
+	// Wrapped stream accepts only the first packet and a part of the second one
+	ASSERT(comm_packet_queue_drain(queue) == 1);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 12);
+	ASSERT(readBuf[0] == 6);
+	ASSERT(memcmp(readBuf + 1, "PACKET", 6) == 0);
+	ASSERT(readBuf[7] == 5);
+	ASSERT(memcmp(readBuf + 8, "QUEU", 4) == 0);
+
+	// Released slot can be reused
+	ASSERT(comm_packet_queue_push(queue, NULL, 0));
+
+	ASSERT(comm_packet_queue_drain(queue) == 2);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 2);
+	ASSERT(readBuf[0] == 'E');
+	ASSERT(readBuf[1] == 0);
+
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+
+	comm_obj_del(queue);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+typedef struct __sink __sink_t;
+
+struct __sink {
+	uint32_t room;    // Bytes accepted before the sink is full
+	uint32_t flushes;
+	bool     fail;
+};
+
+static int32_t COMM_CALL __sink_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	__sink_t* sink = comm_obj_data(stream);
+	(void)in;
+
+	if (sink->fail)
+		return -1;
+
+	if (len > sink->room)
+		len = sink->room;
+
+	sink->room -= len;
+	return len;
+}
+
+static bool COMM_CALL __sink_flush(comm_stream_t* stream) {
+	__sink_t* sink = comm_obj_data(stream);
+
+	sink->flushes++;
+	return true;
+}
+
+static void __flush_error_test() {
+	static const comm_stream_controller_t sinkController = {
+		.write = __sink_write,
+		.flush = __sink_flush
+	};
+
+	size_t memSize = mem_size();
+	__sink_t sink = { .room = 3, .flushes = 0, .fail = false };
+
+	comm_stream_t* stream = comm_stream_new(&sinkController, &sink);
+	comm_packet_queue_t* queue = comm_packet_queue_new(stream, 4, NULL, NULL);
+
+	// Partially written packet is flushed although no packet was completed
+	ASSERT(comm_packet_queue_push(queue, "abcde", 5));
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+	ASSERT(sink.flushes == 1);
+
+	// Nothing written: no flush
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+	ASSERT(sink.flushes == 1);
+
+	// Failures keep the count of packets written so far
+	sink.room = 3;
+	ASSERT(comm_packet_queue_push(queue, "f", 1));
+	ASSERT(comm_packet_queue_drain(queue) == 1);
+	ASSERT(sink.flushes == 2);
+
+	sink.fail = true;
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+	ASSERT_ERROR(COMM_ERROR_IO);
+
+	sink.fail = false;
+	sink.room = 2;
+	ASSERT(comm_packet_queue_drain(queue) == 1);
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+
+	comm_obj_del(queue);
+	comm_obj_del(stream);
+	ASSERT(mem_size() == memSize);
+}
+
+static void* __producer(void* queue) {
+	static uint8_t nextProducer;
+	uint8_t packet[3] = { __atomic_fetch_add(&nextProducer, 1, __ATOMIC_RELAXED) % __PRODUCERS };
+
+	for (uint16_t i = 0; i < __PACKETS_PER_PRODUCER; i++) {
+		memcpy(packet + 1, &i, sizeof(i));
+
+		while (!comm_packet_queue_push(queue, packet, sizeof(packet))) {
+			errno = 0;
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void __producers_test() {
+	size_t memSize = mem_size();
+	uint8_t frame[4];
+	uint16_t next[__PRODUCERS] = { 0 };
+	pthread_t threads[__PRODUCERS];
+
+	comm_buffer_t* buffer = comm_buffer_new(1024, NULL, NULL);
+	comm_packet_queue_t* queue = comm_packet_queue_new(buffer, 16, NULL, NULL);
+
+	for (int i = 0; i < __PRODUCERS; i++)
+		ASSERT(pthread_create(&threads[i], NULL, __producer, queue) == 0);
+
+	// Every packet arrives whole and packets of each producer keep their order
+	for (uint32_t received = 0; received < __PRODUCERS * __PACKETS_PER_PRODUCER;) {
+		if (comm_packet_queue_drain(queue) == 0)
+			sched_yield();
+
+		while (comm_stream_available_read(buffer) >= sizeof(frame)) {
+			uint16_t seq;
+
+			ASSERT(comm_stream_read(buffer, frame, sizeof(frame)) == sizeof(frame));
+			ASSERT(frame[0] == 3 && frame[1] < __PRODUCERS);
+
+			memcpy(&seq, frame + 2, sizeof(seq));
+			ASSERT(seq == next[frame[1]]);
+			next[frame[1]]++;
+			received++;
+		}
+	}
+
+	for (int i = 0; i < __PRODUCERS; i++) {
+		ASSERT(pthread_join(threads[i], NULL) == 0);
+		ASSERT(next[i] == __PACKETS_PER_PRODUCER);
+	}
+
+	ASSERT(comm_packet_queue_drain(queue) == 0);
+
+	comm_obj_del(queue);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_packet_queue() {
+	__invalid_params_test();
+	__push_drain_test();
+	__flush_error_test();
+	__producers_test();
+}
@@ -194,11 +194,65 @@ static void __write_test() {
 	ASSERT(memcmp(storage + 1, packet, storage[0]) == 0);
 	comm_buffer_clear(buffer);
 
+	// Batch
+	comm_stream_vec_t packets[3] = {
+		{ .data = "ONE", .len = 3 },
+		{ .data = NULL,  .len = 0 },
+		{ .data = "TWO", .len = 3 }
+	};
+	memset(storage, 0, sizeof(storage));
+	ASSERT(comm_packet_stream_write_batch(packetStream, packets, 3));
+	ASSERT(memcmp(storage, "\x03ONE\x00\x03TWO", 9) == 0);
+	comm_buffer_clear(buffer);
+
+	packets[1].len = 256;
+	ASSERT(!comm_packet_stream_write_batch(packetStream, packets, 3));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
 	comm_obj_del(buffer);
 	comm_obj_del(packetStream);
 	ASSERT(mem_size() == memSize);
 }
 
+static void __non_blocking_write_test() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_buffer_t* buffer = comm_buffer_new(8, NULL, NULL);
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(buffer, false, NULL, NULL);
+	comm_packet_stream_set_block_write(packetStream, false, 7);
+
+	ASSERT(comm_packet_stream_write(packetStream, "abcde", 5));
+	ASSERT(comm_packet_stream_write(packetStream, "fgh", 3));
+	ASSERT(comm_packet_stream_pending(packetStream) == 2);
+
+	// Packets (and batches) not fitting into the pending buffer are refused as a whole
+	ASSERT(!comm_packet_stream_write(packetStream, "1234567", 7));
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	errno = 0;
+
+	comm_stream_vec_t packets[2] = {
+		{ .data = "ij", .len = 2 },
+		{ .data = "kl", .len = 2 }
+	};
+	ASSERT(!comm_packet_stream_write_batch(packetStream, packets, 2));
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	errno = 0;
+	ASSERT(comm_packet_stream_write_batch(packetStream, packets, 1));
+	ASSERT(comm_packet_stream_pending(packetStream) == 5);
+
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "\x05" "abcde\x03" "f", 8) == 0);
+	ASSERT(comm_stream_flush(packetStream));
+	ASSERT(comm_packet_stream_pending(packetStream) == 0);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 5);
+	ASSERT(memcmp(readBuf, "gh\x02" "ij", 5) == 0);
+
+	comm_obj_del(packetStream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
 static void __test_data() {
 	size_t memSize = mem_size();
 
@@ -222,5 +276,6 @@ void test_packet_stream() {
 	__blocking_buffer_read_test();
 	__non_blocking_buffer_read_test();
 	__write_test();
+	__non_blocking_write_test();
 	__test_data();
 }
@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "reactor.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#ifdef __linux__
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+typedef struct {
+	uint32_t lines;
+	uint32_t packets;
+	uint32_t closes;
+	char     lastLine[16];
+	uint8_t  lastPacket[16];
+	uint8_t  lastPacketLen;
+	bool     removeOnFrame;
+	comm_reactor_t* reactor;
+} __state_t;
+
+static void COMM_CALL __on_line(comm_line_stream_t* lineStream, char* line, void* userData) {
+	__state_t* state = userData;
+
+	state->lines++;
+	strcpy(state->lastLine, line);
+
+	if (state->removeOnFrame)
+		ASSERT(comm_reactor_remove(state->reactor, lineStream));
+}
+
+static void COMM_CALL __on_packet(comm_packet_stream_t* packetStream, uint8_t* packet, uint8_t len, void* userData) {
+	__state_t* state = userData;
+	(void)packetStream;
+
+	state->packets++;
+	memcpy(state->lastPacket, packet, len);
+	state->lastPacketLen = len;
+}
+
+static void COMM_CALL __on_close(comm_stream_t* stream, void* userData) {
+	(void)stream;
+	((__state_t*)userData)->closes++;
+}
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	ASSERT(!comm_reactor_new(COMM_REACTOR_BACKEND_IO_URING + 1, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	bool data;
+	comm_reactor_t* reactor = comm_reactor_new(COMM_REACTOR_BACKEND_AUTO, NULL, &data);
+	ASSERT(reactor);
+	ASSERT(&data == comm_obj_data(reactor));
+	ASSERT(comm_reactor_backend(reactor) == COMM_REACTOR_BACKEND_EPOLL || comm_reactor_backend(reactor) == COMM_REACTOR_BACKEND_IO_URING);
+	ASSERT_EQUALS(PRIu32, 0, comm_reactor_count(reactor));
+
+	// Streams not backed by a file descriptor cannot be registered
+	comm_buffer_t* buffer = comm_buffer_new(16, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(buffer, 16, false, NULL, NULL);
+	ASSERT(!comm_reactor_add_line_stream(reactor, lineStream, __on_line, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_reactor_remove(reactor, lineStream));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	// Only line and packet streams can be registered
+	int fds[2];
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	comm_fd_stream_t* fdStream = comm_fd_stream_new(fds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	ASSERT(!comm_reactor_add_line_stream(reactor, fdStream, __on_line, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_reactor_add_packet_stream(reactor, fdStream, __on_packet, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	// Streams with blocking reads cannot be registered
+	comm_line_stream_t* blockingLineStream = comm_line_stream_new(fdStream, 16, true, NULL, NULL);
+	ASSERT(!comm_reactor_add_line_stream(reactor, blockingLineStream, __on_line, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	comm_packet_stream_t* blockingPacketStream = comm_packet_stream_new(fdStream, true, NULL, NULL);
+	ASSERT(!comm_reactor_add_packet_stream(reactor, blockingPacketStream, __on_packet, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT_EQUALS(PRIu32, 0, comm_reactor_count(reactor));
+	comm_obj_del(blockingPacketStream);
+	comm_obj_del(blockingLineStream);
+	comm_obj_del(fdStream);
+	close(fds[1]);
+
+	// Nothing registered: times out
+	ASSERT(comm_reactor_run_once(reactor, 0) == 0);
+
+	comm_obj_del(lineStream);
+	comm_obj_del(buffer);
+	comm_obj_del(reactor);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_dispatch(uint32_t backend) {
+	size_t memSize = mem_size();
+	__state_t state = { 0 };
+	int lineFds[2], packetFds[2];
+
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, lineFds) == 0);
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, packetFds) == 0);
+
+	comm_reactor_t* reactor = comm_reactor_new(backend, NULL, NULL);
+	state.reactor = reactor;
+
+	if (!reactor) {
+		// Backend not available in this environment
+		ASSERT(backend == COMM_REACTOR_BACKEND_IO_URING);
+		ASSERT_ERROR(COMM_ERROR_IO);
+		close(lineFds[0]);
+		close(lineFds[1]);
+		close(packetFds[0]);
+		close(packetFds[1]);
+		return;
+	}
+
+	ASSERT(comm_reactor_backend(reactor) == backend);
+
+	comm_fd_stream_t* lineIn  = comm_fd_stream_new(lineFds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* lineOut = comm_fd_stream_new(lineFds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* packetIn  = comm_fd_stream_new(packetFds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* packetOut = comm_fd_stream_new(packetFds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+
+	comm_line_stream_t* lineReader = comm_line_stream_new(lineIn, 16, false, NULL, NULL);
+	comm_line_stream_t* lineWriter = comm_line_stream_new(lineOut, 16, false, NULL, NULL);
+	comm_packet_stream_t* packetReader = comm_packet_stream_new(packetIn, false, NULL, NULL);
+	comm_packet_stream_t* packetWriter = comm_packet_stream_new(packetOut, false, NULL, NULL);
+
+	ASSERT(comm_reactor_add_line_stream(reactor, lineReader, __on_line, __on_close, &state));
+	ASSERT(!comm_reactor_add_line_stream(reactor, lineReader, __on_line, __on_close, &state)); // Already registered
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(comm_reactor_add_packet_stream(reactor, packetReader, __on_packet, __on_close, &state));
+	ASSERT_EQUALS(PRIu32, 2, comm_reactor_count(reactor));
+
+	// Only streams with data are dispatched
+	ASSERT(comm_line_stream_write(lineWriter, "Hello"));
+	ASSERT(comm_line_stream_write(lineWriter, "World"));
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 2);
+	ASSERT_EQUALS(PRIu32, 2, state.lines);
+	ASSERT_EQUALS(PRIu32, 0, state.packets);
+	ASSERT_STR_EQUALS("World", state.lastLine);
+
+	// Partial frames are kept until complete
+	ASSERT(comm_stream_write(packetOut, "\x03" "ab", 3) == 3);
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 0);
+	ASSERT(comm_stream_write(packetOut, "c", 1) == 1);
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 1);
+	ASSERT_EQUALS(PRIu32, 1, state.packets);
+	ASSERT(state.lastPacketLen == 3 && memcmp(state.lastPacket, "abc", 3) == 0);
+
+	// Removal from callback stops dispatching of that stream
+	state.removeOnFrame = true;
+	ASSERT(comm_line_stream_write(lineWriter, "One"));
+	ASSERT(comm_line_stream_write(lineWriter, "Two"));
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 1);
+	ASSERT_STR_EQUALS("One", state.lastLine);
+	ASSERT_EQUALS(PRIu32, 1, comm_reactor_count(reactor));
+
+	// Hang up
+	comm_obj_del(packetWriter);
+	comm_obj_del(packetOut);
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 0);
+	ASSERT_EQUALS(PRIu32, 1, state.closes);
+	ASSERT_EQUALS(PRIu32, 0, comm_reactor_count(reactor));
+
+	comm_obj_del(reactor);
+	comm_obj_del(packetReader);
+	comm_obj_del(packetIn);
+	comm_obj_del(lineReader);
+	comm_obj_del(lineWriter);
+	comm_obj_del(lineIn);
+	comm_obj_del(lineOut);
+	ASSERT(mem_size() == memSize);
+}
+
+// Pending output of streams using non-blocking writes is resumed once they become writable
+static void __test_resume(uint32_t backend) {
+	size_t memSize = mem_size();
+	__state_t state = { 0 };
+	uint8_t packet[200], readBuf[4096];
+	int fds[2];
+
+	comm_reactor_t* reactor = comm_reactor_new(backend, NULL, NULL);
+
+	if (!reactor) {
+		ASSERT(backend == COMM_REACTOR_BACKEND_IO_URING);
+		errno = 0;
+		return;
+	}
+
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	comm_fd_stream_t* fdStream = comm_fd_stream_new(fds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(fdStream, false, NULL, NULL);
+	comm_packet_stream_set_block_write(packetStream, false, 0);
+	ASSERT(comm_reactor_add_packet_stream(reactor, packetStream, __on_packet, __on_close, &state));
+
+	// Peer is slow: output ends up queued
+	memset(packet, 0x5a, sizeof(packet));
+	uint64_t total = 0;
+
+	while (comm_packet_stream_pending(packetStream) == 0) {
+		ASSERT(comm_packet_stream_write(packetStream, packet, sizeof(packet)));
+		total += sizeof(packet) + 1;
+	}
+
+	ASSERT(comm_packet_stream_write(packetStream, packet, sizeof(packet)));
+	total += sizeof(packet) + 1;
+
+	for (int i = 0; i < 1000 && total > 0; i++) {
+		ssize_t received = recv(fds[1], readBuf, sizeof(readBuf), MSG_DONTWAIT);
+
+		if (received > 0) {
+			total -= (uint64_t)received;
+		} else {
+			errno = 0; // Nothing sent yet (io_uring output is submitted by comm_reactor_run_once())
+		}
+
+		ASSERT(comm_reactor_run_once(reactor, 100) >= 0);
+	}
+
+	ASSERT(total == 0);
+	ASSERT(comm_packet_stream_pending(packetStream) == 0);
+	ASSERT_EQUALS(PRIu32, 0, state.closes);
+
+	comm_obj_del(reactor);
+	comm_obj_del(packetStream);
+	comm_obj_del(fdStream);
+	close(fds[1]);
+	ASSERT(mem_size() == memSize);
+}
+
+// Output of registered streams reaches the peer, and I/O still queued on removal is not lost
+static void __test_queued_io(uint32_t backend) {
+	size_t memSize = mem_size();
+	__state_t state = { 0 };
+	char readBuf[16];
+	int fds[2];
+
+	comm_reactor_t* reactor = comm_reactor_new(backend, NULL, NULL);
+
+	if (!reactor) {
+		ASSERT(backend == COMM_REACTOR_BACKEND_IO_URING);
+		errno = 0;
+		return;
+	}
+
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	comm_fd_stream_t* fdStream = comm_fd_stream_new(fds[0], COMM_FD_STREAM_NONBLOCK | COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(fdStream, 16, false, NULL, NULL);
+	ASSERT(comm_reactor_add_line_stream(reactor, lineStream, __on_line, __on_close, &state));
+
+	ASSERT(comm_line_stream_write(lineStream, "ping"));
+	ASSERT(comm_reactor_run_once(reactor, 0) == 0);
+	ASSERT(recv(fds[1], readBuf, sizeof(readBuf), 0) == 5);
+	ASSERT(memcmp(readBuf, "ping\r", 5) == 0);
+
+	ASSERT(send(fds[1], "pong\rlate\r", 10, 0) == 10);
+	ASSERT(comm_line_stream_write(lineStream, "bye"));
+	ASSERT(comm_reactor_run_once(reactor, 1000) == 2);
+	ASSERT_STR_EQUALS("late", state.lastLine);
+
+	ASSERT(send(fds[1], "after\r", 6, 0) == 6);
+	ASSERT(comm_line_stream_write(lineStream, "queued"));
+	ASSERT(comm_reactor_remove(reactor, lineStream));
+
+	ASSERT(comm_stream_flush(lineStream));
+	ASSERT(recv(fds[1], readBuf, 4, MSG_WAITALL) == 4);
+	ASSERT(memcmp(readBuf, "bye\r", 4) == 0);
+	ASSERT(recv(fds[1], readBuf, 7, MSG_WAITALL) == 7);
+	ASSERT(memcmp(readBuf, "queued\r", 7) == 0);
+
+	ASSERT(comm_stream_wait_readable(lineStream, 1000));
+	ASSERT_STR_EQUALS("after", comm_line_stream_read(lineStream));
+	ASSERT_EQUALS(PRIu32, 0, state.closes);
+
+	comm_obj_del(reactor);
+	comm_obj_del(lineStream);
+	comm_obj_del(fdStream);
+	close(fds[1]);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_reactor() {
+	__test_new();
+	__test_dispatch(COMM_REACTOR_BACKEND_EPOLL);
+	__test_dispatch(COMM_REACTOR_BACKEND_IO_URING);
+	__test_resume(COMM_REACTOR_BACKEND_EPOLL);
+	__test_resume(COMM_REACTOR_BACKEND_IO_URING);
+	__test_queued_io(COMM_REACTOR_BACKEND_EPOLL);
+	__test_queued_io(COMM_REACTOR_BACKEND_IO_URING);
+}
+#else
+void test_reactor() {}
+#endif
@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "slab.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <comm/_slab.h>
+#include <string.h>
+
+static void __test_reuse() {
+	size_t memSize = mem_size();
+
+	void* a = _comm_slab_alloc(40);
+	void* b = _comm_slab_alloc(40);
+	ASSERT(a && b && a != b);
+	ASSERT(((uintptr_t)a % sizeof(void*)) == 0);
+	ASSERT(mem_size() > memSize);
+
+	// Blocks are independent
+	memset(a, 0xaa, 40);
+	memset(b, 0xbb, 40);
+	ASSERT(((uint8_t*)a)[39] == 0xaa);
+
+	// Freed block is handed out again without touching the underlying allocator
+	size_t slabSize = mem_size();
+	_comm_slab_free(a);
+	ASSERT(mem_size() == slabSize);
+	ASSERT(_comm_slab_alloc(64) == a); // Same size class
+
+	// Other size class
+	void* c = _comm_slab_alloc(300);
+	ASSERT(c);
+	ASSERT(mem_size() > slabSize);
+
+	_comm_slab_free(a);
+	_comm_slab_free(b);
+	_comm_slab_free(c);
+	_comm_slab_free(NULL);
+
+	_comm_slab_trim();
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_large() {
+	size_t memSize = mem_size();
+
+	void* ptr = _comm_slab_alloc(_COMM_SLAB_MAX_BLOCK_SIZE + 1);
+	ASSERT(ptr);
+	ASSERT(mem_size() > memSize + _COMM_SLAB_MAX_BLOCK_SIZE);
+
+	_comm_slab_free(ptr);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_trim() {
+	size_t memSize = mem_size();
+	void* blocks[64];
+
+	for (int i = 0; i < 64; i++) {
+		blocks[i] = _comm_slab_alloc(32);
+		ASSERT(blocks[i]);
+	}
+
+	// Slabs with blocks in use are kept
+	for (int i = 1; i < 64; i++)
+		_comm_slab_free(blocks[i]);
+
+	_comm_slab_trim();
+	ASSERT(mem_size() > memSize);
+
+	_comm_slab_free(blocks[0]);
+	_comm_slab_trim();
+	ASSERT(mem_size() == memSize);
+}
+
+void test_slab() {
+	__test_reuse();
+	__test_large();
+	__test_trim();
+}
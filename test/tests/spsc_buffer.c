@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "spsc_buffer.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	ASSERT(!comm_spsc_buffer_new(0, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_spsc_buffer_new(12, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	bool data;
+	comm_spsc_buffer_t* buffer = comm_spsc_buffer_new(16, NULL, &data);
+	ASSERT(buffer);
+	ASSERT(&data == comm_obj_data(buffer));
+	ASSERT(comm_spsc_buffer_capacity(buffer) == 16);
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 16, comm_stream_available_write(buffer));
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_read_write() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[32];
+
+	comm_spsc_buffer_t* buffer = comm_spsc_buffer_new(16, NULL, NULL);
+	ASSERT(buffer);
+
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 0);
+
+	ASSERT(comm_stream_write(buffer, "Hello world!", 12) == 12);
+	ASSERT_EQUALS(PRIu32, 12, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 4, comm_stream_available_write(buffer));
+
+	ASSERT(comm_stream_read(buffer, readBuf, 6) == 6);
+	ASSERT(memcmp(readBuf, "Hello ", 6) == 0);
+
+	// Wrapping around the end of storage
+	ASSERT(comm_stream_write(buffer, "0123456789", 10) == 10);
+
+	// Full buffer
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_write(buffer));
+	ASSERT(comm_stream_write(buffer, "x", 1) == 0);
+
+	ASSERT(comm_stream_read(buffer, NULL, 6) == 6); // Discard
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 10);
+	ASSERT(memcmp(readBuf, "0123456789", 10) == 0);
+
+	// Empty buffer
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(buffer));
+	ASSERT_EQUALS(PRIu32, 16, comm_stream_available_write(buffer));
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_mirrored() {
+	size_t memSize = mem_size();
+	size_t capacity = 4096;
+	uint8_t readBuf[16];
+
+	comm_spsc_buffer_t* buffer = comm_spsc_buffer_new_mirrored(capacity, NULL, NULL);
+	ASSERT(buffer);
+	ASSERT(comm_spsc_buffer_capacity(buffer) == capacity);
+
+	// Move cursors close to the end of storage, then write across it
+	for (size_t i = 0; i < capacity - 4; i += sizeof(readBuf)) {
+		uint32_t len = (uint32_t)(capacity - 4 - i < sizeof(readBuf) ? capacity - 4 - i : sizeof(readBuf));
+		ASSERT(comm_stream_write(buffer, readBuf, len) == (int32_t)len);
+		ASSERT(comm_stream_read(buffer, NULL, len) == (int32_t)len);
+	}
+
+	ASSERT(comm_stream_write(buffer, "mirrored", 8) == 8);
+	ASSERT(comm_stream_read(buffer, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "mirrored", 8) == 0);
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_wait() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[4];
+
+	comm_spsc_buffer_t* buffer = comm_spsc_buffer_new(4, NULL, NULL);
+	ASSERT(buffer);
+
+#ifdef __linux__
+	// Nothing to read
+	ASSERT(!comm_stream_wait_readable(buffer, 10));
+#endif
+	ASSERT(comm_stream_wait_writable(buffer, 10));
+
+	ASSERT(comm_stream_write(buffer, "full", 4) == 4);
+	ASSERT(comm_stream_wait_readable(buffer, 10));
+#ifdef __linux__
+	// No room to write
+	ASSERT(!comm_stream_wait_writable(buffer, 10));
+#endif
+
+	ASSERT(comm_stream_read(buffer, readBuf, 1) == 1);
+	ASSERT(comm_stream_wait_writable(buffer, COMM_STREAM_WAIT_FOREVER));
+	ASSERT(comm_stream_wait_readable(buffer, COMM_STREAM_WAIT_FOREVER));
+
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
+}
+
+void test_spsc_buffer() {
+	__test_new();
+	__test_read_write();
+	__test_mirrored();
+	__test_wait();
+}
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stats_stream.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	ASSERT(!comm_stats_stream_new(NULL, NULL, NULL));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	comm_buffer_t* buffer = comm_buffer_new(16, NULL, NULL);
+
+	bool data;
+	comm_stats_stream_t* stream = comm_stats_stream_new(buffer, NULL, &data);
+	ASSERT(stream);
+	ASSERT(&data == comm_obj_data(stream));
+	ASSERT_EQUALS(PRIu32, 16, comm_stream_available_write(stream));
+
+	comm_stats_stream_snapshot_t snapshot;
+	comm_stats_stream_snapshot(stream, &snapshot);
+	ASSERT(snapshot.read.calls == 0 && snapshot.write.calls == 0 && snapshot.flushes == 0);
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_counters() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+	comm_stats_stream_snapshot_t snapshot;
+
+	comm_buffer_t* buffer = comm_buffer_new(16, NULL, NULL);
+	comm_stats_stream_t* stream = comm_stats_stream_new(buffer, NULL, NULL);
+
+	ASSERT(comm_stream_write(stream, "abc", 3) == 3);
+	ASSERT(comm_stream_write(stream, "0123456789abcdef", 16) == 13); // Short
+	ASSERT(comm_stream_write(stream, "x", 1) == 0);                  // Full
+	ASSERT(comm_stream_write(stream, NULL, 0) == 0);
+	ASSERT(comm_stream_flush(stream));
+
+	ASSERT(comm_stream_read(stream, readBuf, 4) == 4);
+	comm_stream_vec_t vec[2] = { { readBuf, 8 }, { readBuf + 8, 8 } };
+	ASSERT(comm_stream_readv(stream, vec, 2) == 12);
+	ASSERT(comm_stream_read(stream, readBuf, 1) == 0);               // Empty
+
+	comm_stats_stream_snapshot(stream, &snapshot);
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, snapshot.write.calls);
+	ASSERT_EQUALS(PRIu64, (uint64_t)16, snapshot.write.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.zeroReturns);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.shortReturns);
+	ASSERT_EQUALS(PRIu64, (uint64_t)0, snapshot.write.errors);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.sizes[0]);  // 0
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.sizes[1]);  // 1
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.sizes[2]);  // 3
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.write.sizes[5]);  // 16
+
+	ASSERT_EQUALS(PRIu64, (uint64_t)3, snapshot.read.calls);
+	ASSERT_EQUALS(PRIu64, (uint64_t)16, snapshot.read.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.read.zeroReturns);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.read.shortReturns);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.read.sizes[3]);   // 4
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.read.sizes[5]);   // 16 (vectored)
+
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, snapshot.flushes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)0, snapshot.flushErrors);
+
+	comm_stats_stream_reset(stream);
+	comm_stats_stream_snapshot(stream, &snapshot);
+	ASSERT(snapshot.read.calls == 0 && snapshot.write.sizes[5] == 0 && snapshot.flushes == 0);
+
+	comm_obj_del(stream);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_stacking() {
+	size_t memSize = mem_size();
+	comm_stats_stream_snapshot_t inner, outer;
+
+	// Pass-through layers are skipped by outer wrappers, layers recording statistics are not
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_stats_stream_t* innerStats = comm_stats_stream_new(buffer, NULL, NULL);
+	comm_line_stream_t* lineStream = comm_line_stream_new(innerStats, 16, false, NULL, NULL);
+	comm_stats_stream_t* outerStats = comm_stats_stream_new(lineStream, NULL, NULL);
+	comm_line_stream_t* outerLineStream = comm_line_stream_new(outerStats, 16, false, NULL, NULL);
+
+	ASSERT(comm_line_stream_write(outerLineStream, "abc"));
+	ASSERT_STR_EQUALS("abc", comm_line_stream_read(outerLineStream));
+
+	comm_stats_stream_snapshot(innerStats, &inner);
+	comm_stats_stream_snapshot(outerStats, &outer);
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, inner.write.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, outer.write.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, inner.read.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, outer.read.bytes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, inner.flushes);
+	ASSERT_EQUALS(PRIu64, (uint64_t)1, outer.flushes);
+
+	comm_obj_del(outerLineStream);
+	comm_obj_del(outerStats);
+	comm_obj_del(lineStream);
+	comm_obj_del(innerStats);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_stats_stream() {
+	__test_new();
+	__test_counters();
+	__test_stacking();
+}
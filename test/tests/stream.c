@@ -24,6 +24,7 @@ SOFTWARE.
 #include "../assert.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 static void __test_data() {
 	size_t memSize = mem_size();
@@ -58,7 +59,38 @@ static void __test_void_stream() {
 	ASSERT(mem_size() == memSize);
 }
 
+static void __test_generic_vec() {
+	size_t memSize = mem_size();
+	uint8_t a[4];
+	uint8_t b[8];
+
+	// Chain buffer has no native scatter/gather support
+	comm_stream_t* stream = comm_chain_buffer_new(4, 10, NULL, NULL);
+	ASSERT(stream);
+
+	comm_stream_vec_t writeVec[3] = {
+		{ .data = "abc",     .len = 3 },
+		{ .data = NULL,      .len = 0 },
+		{ .data = "defghij", .len = 7 }
+	};
+	ASSERT_EQUALS(PRIi32, 10, comm_stream_writev(stream, writeVec, 3));
+	ASSERT_EQUALS(PRIi32, 0, comm_stream_writev(stream, writeVec, 3));
+
+	comm_stream_vec_t readVec[2] = {
+		{ .data = a, .len = sizeof(a) },
+		{ .data = b, .len = sizeof(b) }
+	};
+	ASSERT_EQUALS(PRIi32, 10, comm_stream_readv(stream, readVec, 2));
+	ASSERT(memcmp(a, "abcd", 4) == 0);
+	ASSERT(memcmp(b, "efghij", 6) == 0);
+
+	comm_obj_del(stream);
+
+	ASSERT(mem_size() == memSize);
+}
+
 void test_stream() {
 	__test_void_stream();
+	__test_generic_vec();
 	__test_data();
 }
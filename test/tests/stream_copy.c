@@ -0,0 +1,196 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "stream_copy.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static const char __data[] = "The quick brown fox jumps over the lazy dog";
+
+#define __DATA_LEN ((uint32_t)sizeof(__data) - 1)
+
+static void __assert_content(comm_stream_t* stream, const char* expected, uint32_t len) {
+	char readBuf[64];
+
+	ASSERT_EQUALS(PRIu32, len, comm_stream_available_read(stream));
+	ASSERT(comm_stream_read(stream, readBuf, len) == (int32_t)len);
+	ASSERT(memcmp(readBuf, expected, len) == 0);
+}
+
+static void __test_params() {
+	comm_buffer_t* buffer = comm_buffer_new(8, NULL, NULL);
+
+	ASSERT(comm_stream_copy(NULL, buffer, 1) == -1);
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(comm_stream_copy(buffer, buffer, 1) == -1);
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	comm_obj_del(buffer);
+}
+
+static void __test_streams() {
+	size_t memSize = mem_size();
+
+	comm_buffer_t* buffer = comm_buffer_new(64, NULL, NULL);
+	comm_chain_buffer_t* chainA = comm_chain_buffer_new(8, 0, NULL, NULL);
+	comm_chain_buffer_t* chainB = comm_chain_buffer_new(8, 0, NULL, NULL);
+
+	// Buffer source, limited by maxBytes
+	ASSERT(comm_stream_write(buffer, __data, __DATA_LEN) == (int32_t)__DATA_LEN);
+	ASSERT(comm_stream_copy(buffer, chainA, 9) == 9);
+	ASSERT(comm_stream_copy(buffer, chainA, UINT64_MAX) == __DATA_LEN - 9);
+	ASSERT(comm_stream_copy(buffer, chainA, UINT64_MAX) == 0);
+
+	// Generic
+	ASSERT(comm_stream_copy(chainA, chainB, UINT64_MAX) == __DATA_LEN);
+
+	// Buffer destination (wrapping around its storage)
+	ASSERT(comm_stream_write(buffer, "0123456789", 10) == 10);
+	ASSERT(comm_stream_read(buffer, NULL, 10) == 10);
+	ASSERT(comm_stream_copy(chainB, buffer, UINT64_MAX) == __DATA_LEN);
+	__assert_content(buffer, __data, __DATA_LEN);
+
+	comm_obj_del(chainB);
+	comm_obj_del(chainA);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_full_destination() {
+	size_t memSize = mem_size();
+
+	comm_buffer_t* src = comm_buffer_new(64, NULL, NULL);
+	comm_buffer_t* dst = comm_buffer_new(8, NULL, NULL);
+	comm_chain_buffer_t* chainA = comm_chain_buffer_new(8, 0, NULL, NULL);
+	comm_chain_buffer_t* chainB = comm_chain_buffer_new(8, 16, NULL, NULL);
+
+	// Full destinations which cannot be waited for stop the copy, leaving data in source
+	ASSERT(comm_stream_write(src, __data, __DATA_LEN) == (int32_t)__DATA_LEN);
+	ASSERT(comm_stream_write(dst, "01234567", 8) == 8);
+	ASSERT(comm_stream_copy(src, dst, UINT64_MAX) == 0);
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	ASSERT_EQUALS(PRIu32, __DATA_LEN, comm_stream_available_read(src));
+
+	ASSERT(comm_stream_read(dst, NULL, 8) == 8);
+	ASSERT(comm_stream_copy(src, dst, UINT64_MAX) == 8);
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	__assert_content(dst, __data, 8);
+
+	// Generic
+	ASSERT(comm_stream_copy(src, chainA, UINT64_MAX) == __DATA_LEN - 8);
+	ASSERT(comm_stream_copy(chainA, chainB, UINT64_MAX) == 16);
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	ASSERT_EQUALS(PRIu32, __DATA_LEN - 24, comm_stream_available_read(chainA));
+	__assert_content(chainB, __data + 8, 16);
+
+	// Buffer destination
+	ASSERT(comm_stream_write(dst, "01234567", 8) == 8);
+	ASSERT(comm_stream_copy(chainA, dst, UINT64_MAX) == 0);
+	ASSERT_ERROR(COMM_ERROR_AGAIN);
+	ASSERT_EQUALS(PRIu32, __DATA_LEN - 24, comm_stream_available_read(chainA));
+
+	comm_obj_del(chainB);
+	comm_obj_del(chainA);
+	comm_obj_del(dst);
+	comm_obj_del(src);
+	ASSERT(mem_size() == memSize);
+}
+
+#ifdef __linux__
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static comm_fd_stream_t* __temp_file(const char* content, uint32_t len) {
+	FILE* file = tmpfile();
+	ASSERT(file);
+	ASSERT(fwrite(content, 1, len, file) == len);
+	ASSERT(fflush(file) == 0);
+	rewind(file);
+
+	comm_fd_stream_t* stream = comm_fd_stream_new(dup(fileno(file)), COMM_FD_STREAM_CLOSE, NULL, NULL);
+	fclose(file);
+	return stream;
+}
+
+static void __test_fd_streams() {
+	size_t memSize = mem_size();
+	int pipeFds[2], socketFds[2], otherFds[2];
+
+	ASSERT(pipe(pipeFds) == 0);
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, socketFds) == 0);
+	ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, otherFds) == 0);
+
+	comm_fd_stream_t* pipeIn    = comm_fd_stream_new(pipeFds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* pipeOut   = comm_fd_stream_new(pipeFds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* socketA   = comm_fd_stream_new(socketFds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* socketB   = comm_fd_stream_new(socketFds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* otherA    = comm_fd_stream_new(otherFds[0], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* otherB    = comm_fd_stream_new(otherFds[1], COMM_FD_STREAM_CLOSE, NULL, NULL);
+	comm_fd_stream_t* srcFile   = __temp_file(__data, __DATA_LEN);
+	comm_fd_stream_t* dstFile   = __temp_file("", 0);
+	comm_buffer_t*    buffer    = comm_buffer_new(64, NULL, NULL);
+
+	// File -> file (copy_file_range)
+	ASSERT(comm_stream_copy(srcFile, dstFile, UINT64_MAX) == __DATA_LEN);
+	ASSERT(comm_stream_copy(srcFile, dstFile, UINT64_MAX) == 0);
+	ASSERT(lseek(comm_fd_stream_fd(dstFile), 0, SEEK_SET) == 0);
+
+	// File -> pipe (sendfile/splice)
+	ASSERT(comm_stream_copy(dstFile, pipeOut, 4) == 4);
+	ASSERT(comm_stream_copy(dstFile, pipeOut, UINT64_MAX) == __DATA_LEN - 4);
+
+	// Pipe -> socket (splice)
+	ASSERT(comm_stream_copy(pipeIn, socketA, UINT64_MAX) == __DATA_LEN);
+
+	// Socket -> socket (splice through intermediate pipe)
+	ASSERT(comm_stream_copy(socketB, otherA, UINT64_MAX) == __DATA_LEN);
+
+	// Socket -> buffer -> socket
+	ASSERT(comm_stream_copy(otherB, buffer, UINT64_MAX) == __DATA_LEN);
+	ASSERT(comm_stream_copy(buffer, socketB, UINT64_MAX) == __DATA_LEN);
+	__assert_content(socketA, __data, __DATA_LEN);
+
+	comm_obj_del(buffer);
+	comm_obj_del(dstFile);
+	comm_obj_del(srcFile);
+	comm_obj_del(otherB);
+	comm_obj_del(otherA);
+	comm_obj_del(socketB);
+	comm_obj_del(socketA);
+	comm_obj_del(pipeOut);
+	comm_obj_del(pipeIn);
+	ASSERT(mem_size() == memSize);
+}
+#endif
+
+void test_stream_copy() {
+	__test_params();
+	__test_streams();
+	__test_full_destination();
+#ifdef __linux__
+	__test_fd_streams();
+#endif
+}
@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "tee_stream.h"
+#include "../mem.h"
+#include "../assert.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+static void __test_new() {
+	size_t memSize = mem_size();
+
+	bool data;
+	comm_tee_stream_t* tee = comm_tee_stream_new(NULL, &data);
+	ASSERT(tee);
+	ASSERT(&data == comm_obj_data(tee));
+	ASSERT_EQUALS(PRIu32, UINT32_MAX, comm_stream_available_write(tee));
+	ASSERT_EQUALS(PRIu32, 0, comm_stream_available_read(tee));
+
+	// No sinks: data is discarded
+	ASSERT(comm_stream_write(tee, "abc", 3) == 3);
+
+	comm_buffer_t* buffer = comm_buffer_new(8, NULL, NULL);
+
+	ASSERT(!comm_tee_stream_add_sink(tee, buffer, COMM_TEE_STREAM_BUFFER + 1, 0));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(!comm_tee_stream_add_sink(tee, tee, COMM_TEE_STREAM_DROP, 0));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+	ASSERT(comm_tee_stream_add_sink(tee, buffer, COMM_TEE_STREAM_DROP, 0));
+	ASSERT(!comm_tee_stream_add_sink(tee, buffer, COMM_TEE_STREAM_DROP, 0));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	ASSERT(comm_tee_stream_remove_sink(tee, buffer));
+	ASSERT(!comm_tee_stream_remove_sink(tee, buffer));
+	ASSERT_ERROR(COMM_ERROR_INVPARAM);
+
+	comm_obj_del(tee);
+	comm_obj_del(buffer);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_policies() {
+	size_t memSize = mem_size();
+	uint8_t readBuf[64];
+
+	comm_tee_stream_t* tee = comm_tee_stream_new(NULL, NULL);
+	comm_buffer_t* blockSink = comm_buffer_new(64, NULL, NULL);
+	comm_buffer_t* dropSink = comm_buffer_new(8, NULL, NULL);
+	comm_buffer_t* bufferSink = comm_buffer_new(8, NULL, NULL);
+
+	ASSERT(comm_tee_stream_add_sink(tee, blockSink, COMM_TEE_STREAM_BLOCK, 0));
+	ASSERT(comm_tee_stream_add_sink(tee, dropSink, COMM_TEE_STREAM_DROP, 0));
+	ASSERT(comm_tee_stream_add_sink(tee, bufferSink, COMM_TEE_STREAM_BUFFER, 8));
+
+	ASSERT(comm_stream_write(tee, "abcdef", 6) == 6);
+	ASSERT_EQUALS(PRIu32, 6, comm_stream_available_read(dropSink));
+	ASSERT_EQUALS(PRIu32, 6, comm_stream_available_read(bufferSink));
+
+	// Writes are never split on dropping sinks
+	ASSERT(comm_stream_write(tee, "ghij", 4) == 4);
+	ASSERT_EQUALS(PRIu32, 6, comm_stream_available_read(dropSink));
+	ASSERT_EQUALS(PRIu64, (uint64_t)4, comm_tee_stream_dropped(tee, dropSink));
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_read(bufferSink));
+	ASSERT(comm_tee_stream_backlog(tee, bufferSink) == 2);
+
+	ASSERT(comm_stream_write(tee, "kl", 2) == 2);
+	ASSERT_EQUALS(PRIu32, 8, comm_stream_available_read(dropSink));
+	ASSERT(comm_tee_stream_backlog(tee, bufferSink) == 4);
+
+	// Backlog limit
+	ASSERT(comm_stream_write(tee, "mnopq", 5) == 5);
+	ASSERT_EQUALS(PRIu64, (uint64_t)9, comm_tee_stream_dropped(tee, dropSink));
+	ASSERT_EQUALS(PRIu64, (uint64_t)5, comm_tee_stream_dropped(tee, bufferSink));
+	ASSERT(comm_tee_stream_backlog(tee, bufferSink) == 4);
+
+	// Backlog is drained once the sink catches up
+	ASSERT(comm_stream_read(bufferSink, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "abcdefgh", 8) == 0);
+	ASSERT(comm_stream_flush(tee));
+	ASSERT(comm_tee_stream_backlog(tee, bufferSink) == 0);
+	ASSERT(comm_stream_read(bufferSink, readBuf, sizeof(readBuf)) == 4);
+	ASSERT(memcmp(readBuf, "ijkl", 4) == 0);
+
+	ASSERT(comm_stream_read(dropSink, readBuf, sizeof(readBuf)) == 8);
+	ASSERT(memcmp(readBuf, "abcdefkl", 8) == 0);
+
+	ASSERT(comm_stream_read(blockSink, readBuf, sizeof(readBuf)) == 17);
+	ASSERT(memcmp(readBuf, "abcdefghijklmnopq", 17) == 0);
+	ASSERT_EQUALS(PRIu64, (uint64_t)0, comm_tee_stream_dropped(tee, blockSink));
+
+	comm_obj_del(tee);
+	comm_obj_del(bufferSink);
+	comm_obj_del(dropSink);
+	comm_obj_del(blockSink);
+	ASSERT(mem_size() == memSize);
+}
+
+static void __test_packets() {
+	size_t memSize = mem_size();
+	uint8_t len;
+
+	comm_tee_stream_t* tee = comm_tee_stream_new(NULL, NULL);
+	comm_packet_stream_t* packetStream = comm_packet_stream_new(tee, false, NULL, NULL);
+	comm_buffer_t* sinks[3];
+	comm_packet_stream_t* readers[3];
+
+	for (int i = 0; i < 3; i++) {
+		sinks[i] = comm_buffer_new(10, NULL, NULL);
+		readers[i] = comm_packet_stream_new(sinks[i], false, NULL, NULL);
+		ASSERT(comm_tee_stream_add_sink(tee, sinks[i], COMM_TEE_STREAM_DROP, 0));
+	}
+
+	// Second packet does not fit: every sink skips it as a whole
+	ASSERT(comm_packet_stream_write(packetStream, "abcde", 5));
+	ASSERT(comm_packet_stream_write(packetStream, "fghij", 5));
+	ASSERT(comm_packet_stream_write(packetStream, "xyz", 3));
+
+	for (int i = 0; i < 3; i++) {
+		uint8_t* packet = comm_packet_stream_read(readers[i], &len);
+		ASSERT(packet && len == 5 && memcmp(packet, "abcde", 5) == 0);
+		packet = comm_packet_stream_read(readers[i], &len);
+		ASSERT(packet && len == 3 && memcmp(packet, "xyz", 3) == 0);
+		ASSERT(!comm_packet_stream_read(readers[i], &len));
+		ASSERT_EQUALS(PRIu64, (uint64_t)6, comm_tee_stream_dropped(tee, sinks[i]));
+	}
+
+	for (int i = 0; i < 3; i++) {
+		comm_obj_del(readers[i]);
+		comm_obj_del(sinks[i]);
+	}
+
+	comm_obj_del(packetStream);
+	comm_obj_del(tee);
+	ASSERT(mem_size() == memSize);
+}
+
+static int32_t COMM_CALL __failing_write(comm_stream_t* stream, const void* in, uint32_t len) {
+	(void)stream;
+	(void)in;
+	(void)len;
+	return -1;
+}
+
+static void __test_failing_sink() {
+	static const comm_stream_controller_t failingController = {
+		.write = __failing_write
+	};
+
+	size_t memSize = mem_size();
+	uint8_t readBuf[16];
+
+	comm_tee_stream_t* tee = comm_tee_stream_new(NULL, NULL);
+	comm_stream_t* failingSink = comm_stream_new(&failingController, NULL);
+	comm_buffer_t* sink = comm_buffer_new(16, NULL, NULL);
+
+	ASSERT(comm_tee_stream_add_sink(tee, failingSink, COMM_TEE_STREAM_BLOCK, 0));
+	ASSERT(comm_tee_stream_add_sink(tee, sink, COMM_TEE_STREAM_DROP, 0));
+
+	// Write succeeds for the other sinks: the failed blocking sink is reported through errno
+	ASSERT(comm_stream_write(tee, "abc", 3) == 3);
+	ASSERT_ERROR(COMM_ERROR_IO);
+	ASSERT_EQUALS(PRIu64, (uint64_t)3, comm_tee_stream_dropped(tee, failingSink));
+
+	// Failed sinks no longer receive data
+	ASSERT(comm_stream_write(tee, "de", 2) == 2);
+	ASSERT_ERROR(COMM_ERROR_NO_ERROR);
+	ASSERT_EQUALS(PRIu64, (uint64_t)5, comm_tee_stream_dropped(tee, failingSink));
+
+	ASSERT(comm_stream_read(sink, readBuf, sizeof(readBuf)) == 5);
+	ASSERT(memcmp(readBuf, "abcde", 5) == 0);
+
+	comm_obj_del(tee);
+	comm_obj_del(sink);
+	comm_obj_del(failingSink);
+	ASSERT(mem_size() == memSize);
+}
+
+void test_tee_stream() {
+	__test_new();
+	__test_policies();
+	__test_packets();
+	__test_failing_sink();
+}